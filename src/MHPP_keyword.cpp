@@ -111,7 +111,7 @@ vector<MHPP_keyword> MHPP_keyword::parse(const regionizedText &t, const string &
     vector<MHPP_keyword> ret;
 
     // all regions of input file
-    std::vector<regionized::region> regs = t.getRegions();
+    const std::vector<regionized::region> &regs = t.getRegions();
 
     // === mask irrelevant regions for command regex search (literal strings, comments) ===
     string unmasked = t.str();
@@ -158,24 +158,18 @@ vector<MHPP_keyword> MHPP_keyword::parse(const regionizedText &t, const string &
         // map back to unmasked original file
         csit_t matchLastCharInOrig = t.remapExtIteratorToInt(masked, matchLastCharInBlanked);
 
-        // expect exactly one round bracket region starting at opening round bracket
-        vector<regionized::region> tmp;
-        for (const auto &reg : regs)
-            if (reg.startsAt(matchLastCharInOrig) && reg.getRType() == regionized::rType_e::BRK_RND)
-                tmp.push_back(reg);
-        assert(tmp.size() <= 1 && "multiple round-bracket regions cannot start at the same character position");
-        if (tmp.size() != 1)
+        // expect a round bracket region starting at opening round bracket (tree lookup, see regionized::regionStartingAt)
+        const regionized &tree = t.getRegionized();
+        const size_t ixRndBrk = tree.regionStartingAt(matchLastCharInOrig, regionized::rType_e::BRK_RND);
+        if (ixRndBrk == regionized::NONE)
             throw runtime_error(common::errmsg(t, t.remapExtIteratorToInt(masked, s[0].first), t.remapExtIteratorToInt(masked, s[0].second), filenameForError, "MHPP( failed to locate closing bracket"));
-        regionized::region rndBrkReg = tmp.back();
+        const regionized::region &rndBrkReg = tree.getRegion(ixRndBrk);
 
         // expect exactly one double-quoted region within the round brackets
-        tmp.clear();
-        for (const auto &reg : regs)
-            if ((reg.getRType() == regionized::rType_e::DQUOTE_BODY) && rndBrkReg.contains(reg))
-                tmp.push_back(reg);
-        if (tmp.size() != 1)
-            throw runtime_error(common::errmsg(t, t.remapExtIteratorToInt(masked, s[0].first), t.remapExtIteratorToInt(masked, s[0].second), filenameForError, "MHPP(...) requires single double-quoted argument (got " + to_string(tmp.size()) + ")"));
-        regionized::region dblQuotArg = tmp.back();
+        const vector<size_t> args = tree.descendants(ixRndBrk, regionized::rType_e::DQUOTE_BODY);
+        if (args.size() != 1)
+            throw runtime_error(common::errmsg(t, t.remapExtIteratorToInt(masked, s[0].first), t.remapExtIteratorToInt(masked, s[0].second), filenameForError, "MHPP(...) requires single double-quoted argument (got " + to_string(args.size()) + ")"));
+        const regionized::region &dblQuotArg = tree.getRegion(args.back());
         std::cout << dblQuotArg.str() << std::endl;
 
         // === end of MHPP("") start of C++ declaration ===
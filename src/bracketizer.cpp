@@ -1,5 +1,5 @@
 //  g++ -O0 -g src/bracketizer.cpp -Wall -fmax-errors=1 -static -Wextra -Weffc++ -D_GLIBCXX_DEBUG
-// g++ -O0 -g src/bracketizer.cpp src/regionized.cpp src/regionizedText.cpp src/MHPP_keyword.cpp src/common.cpp -Wall -fmax-errors=1 -static -Wextra -Weffc++ -D_GLIBCXX_DEBUG
+// g++ -O0 -g src/bracketizer.cpp src/regionized.cpp src/regionizedText.cpp src/MHPP_keyword.cpp src/common.cpp src/stringRegion.cpp src/lineIndex.cpp -Wall -fmax-errors=1 -static -Wextra -Weffc++ -D_GLIBCXX_DEBUG
 #include <cassert>
 #include <iostream>  // debug
 #include <iterator>
@@ -1,28 +1,204 @@
 #include "codeGen.h"
 
 using std::vector, std::string, std::runtime_error, std::map, std::cout, std::endl, std::regex, std::to_string;
+
 MHPP("public")
-codeGen::codeGen(bool annotate) : annotate(annotate) {}
+codeGen::codeGen(bool annotate, inputMode_e inputMode) : annotate(annotate), inputMode(inputMode) {}
 
 MHPP("public")
 void codeGen::pass1(const std::string& fname, bool clean) {
-    // === read file contents ===
-    string all = readFile(fname);
-    myRegexRange rall = myRegexRange(all, fname);
-    auto r = filebodyByFilename.insert({fname, rall});
-    if (!r.second) throw runtime_error("duplicate filename: '" + fname + "'");
+    myRegexRange::root_t rall = load(fname, inputMode);
+    const vector<vector<myRegexRange>> decls = clean ? vector<vector<myRegexRange>>() : scanCached(*rall);
+    addFile(fname, std::move(rall), decls);
+}
 
-    if (!clean) {
-        // === break into nonmatch|match|nonmatch|...|nonmatch stream ===
-        myAppRegex rx = myAppRegex::comment().makeGrp() | myAppRegex::MHPP_classfun().makeGrp() | myAppRegex::MHPP_classvar().makeGrp();
+MHPP("public")
+// pass1 over all files. Reading and scanning is distributed over the pool, results are merged in argument order
+void codeGen::pass1(const std::vector<std::string>& fnames, bool clean, workerPool& pool) {
+    const size_t nFiles = fnames.size();
+    vector<myRegexRange::root_t> bodies(nFiles);
+    vector<vector<vector<myRegexRange>>> decls(nFiles);
+    if (inputMode == INPUT_BATCHREAD) {
+        scanBatchRead(fnames, clean, pool, bodies, decls);
+    } else {
+        pool.run(nFiles, [&](size_t ix) {
+            bodies[ix] = load(fnames[ix], inputMode);
+            if (!clean)
+                decls[ix] = scanCached(*bodies[ix]);
+        });
+    }
+
+    // === merge (order-dependent e.g. pImpl constructor generation) ===
+    for (size_t ix = 0; ix < nFiles; ++ix)
+        addFile(fnames[ix], std::move(bodies[ix]), decls[ix]);
+}
 
-        vector<myRegexRange> nonCapt;
-        vector<map<string, myRegexRange>> capt;
-        rall.splitByMatches(rx, nonCapt, capt);
+MHPP("public")
+// resident mode: re-reads changed files and rewrites files whose MHPP("begin ...") sections change as a result. Returns written files.
+// The first call processes all files. Rewritten files are rescanned from their new contents for the next call
+std::vector<std::string> codeGen::regenerate(const std::vector<std::string>& changed, workerPool& pool) {
+    // === re-read changed files, skip those with unchanged contents (e.g. our own writes) ===
+    for (const string& fname : changed)
+        if (filebodyByFilename.find(fname) == filebodyByFilename.end())
+            throw runtime_error("'" + fname + "' is not one of the processed files");
+    vector<myRegexRange::root_t> bodies(changed.size());
+    pool.run(changed.size(), [&](size_t ix) { bodies[ix] = load(changed[ix], inputMode); });
+    vector<string> modified;
+    vector<myRegexRange::root_t> modifiedBodies;
+    for (size_t ix = 0; ix < changed.size(); ++ix) {
+        const myRegexRange& old = *filebodyByFilename.at(changed[ix]);
+        if (!std::equal(bodies[ix]->begin(), bodies[ix]->end(), old.begin(), old.end())) {
+            modified.push_back(changed[ix]);
+            modifiedBodies.push_back(std::move(bodies[ix]));
+        }
+    }
+    // (also after a failed call: see below)
+    const bool isFirst = (sectionsByFilename.size() == 0);
+    if ((modified.size() == 0) && !isFirst)
+        return vector<string>();
+    try {
+        return regenerateModified(modified, modifiedBodies, isFirst, pool);
+    } catch (...) {
+        // === class state is partial: the next call must not compare against it. Process all files, as on the first call ===
+        sectionsByFilename.clear();
+        fileRewriteByName.clear();
+        throw;
+    }
+}
 
-        for (const auto& a : capt)
+MHPP("private")
+// regenerate() for files whose contents changed. isFirst: process all files
+std::vector<std::string> codeGen::regenerateModified(const std::vector<std::string>& modified, std::vector<myRegexRange::root_t>& modifiedBodies, bool isFirst, workerPool& pool) {
+    rescan(modified, modifiedBodies, pool);
+
+    // === collect declarations from scratch, in original file order (see pass1) ===
+    const map<string, oneClass> oldClasses = classesByName;
+    classesByName.clear();
+    classDone.clear();
+    sourcesByClass.clear();
+    for (const string& fname : filenameOrder) {
+        currentSource = fname;
+        for (const auto& a : declsByFilename[fname])
             MHPP_classitem(a);
     }
+    currentSource.clear();
+
+    // === affected: classes with different declarations ===
+    std::set<string> affected;
+    for (const auto& [classname, c] : classesByName) {
+        auto it = oldClasses.find(classname);
+        if ((it == oldClasses.end()) || !it->second.equals(c))
+            affected.insert(classname);
+    }
+    for (const auto& it : oldClasses)
+        if (classesByName.find(it.first) == classesByName.end())
+            affected.insert(it.first);
+
+    // === regenerate files with affected sections and modified files. Others are known to be up to date ===
+    vector<string> todo;
+    for (const string& fname : filenameOrder) {
+        bool isTodo = isFirst || (std::find(modified.begin(), modified.end(), fname) != modified.end());
+        for (const string& classname : sectionsByFilename[fname])
+            isTodo |= (affected.find(classname) != affected.end());
+        if (isTodo) {
+            todo.push_back(fname);
+        } else {
+            for (const string& classname : sectionsByFilename[fname]) {
+                auto it = classDone.find(classname);
+                if (it != classDone.end()) it->second = true;
+            }
+        }
+    }
+
+    fileRewriteByName.clear();
+    pass2(todo, /*clean*/ false, pool);
+    checkAllClassesDone();
+    pass3(todo, pool);
+
+    // === written files: continue from the new contents ===
+    vector<string> written;
+    vector<myRegexRange::root_t> writtenBodies;
+    for (auto& it : fileRewriteByName) {
+        written.push_back(it.first);
+        writtenBodies.push_back(myRegexRange::own(std::move(it.second), it.first));
+    }
+    fileRewriteByName.clear();
+    rescan(written, writtenBodies, pool);
+    return written;
+}
+
+MHPP("public")
+// looks up scan() results in directory dir before scanning, stores new results there
+void codeGen::useCache(const std::string& dir) {
+    const string flags = string(annotate ? "-annotate " : "") + (myRegexBase::getEngine() == myRegexBase::ENGINE_NFA ? "-nfa" : "");
+    // a changed scan pattern invalidates all entries
+    cache = std::make_unique<scanCache>(dir, flags + "\n" + myAppRegexCt::scanDecl.str());
+}
+
+MHPP("public static")
+// reads file contents, optionally as read-only memory mapping
+myRegexRange::root_t codeGen::load(const std::string& fname, inputMode_e inputMode) {
+    if (inputMode == INPUT_MMAP)
+        return myRegexRange::mapFile(fname);
+    return myRegexRange::own(fileIngest::readFile(fname), fname);
+}
+
+MHPP("public static")
+// true if text contains "MHPP". Skips with memchr to candidate positions
+bool codeGen::hasMarker(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 4) {
+        p = static_cast<const char*>(std::memchr(p, 'M', end - p - 3));
+        if (p == nullptr) return false;
+        if (std::memcmp(p, "MHPP", 4) == 0) return true;
+        ++p;
+    }
+    return false;
+}
+
+MHPP("public static")
+// regex search for tagged definitions. Does not access codeGen state (may run on worker thread)
+std::vector<std::vector<myRegexRange>> codeGen::scan(const myRegexRange& body) {
+    // === files without marker can't contain tagged definitions ===
+    vector<vector<myRegexRange>> decls;
+    if (!hasMarker(body.begin(), body.end()))
+        return decls;
+
+    // pattern composed at compile time, matcher built once per process, shared by all files (and all --manifest groups)
+    static constexpr const auto& pattern = myAppRegexCt::scanDecl;
+    // every match starts with one of these (derived from the expression tree): matching is only attempted there
+    static const vector<string> anchors = myRegexBase(pattern).getAst().leadingLiterals();
+    // comments are matched only to skip tagged definitions inside them
+    static constexpr size_t ixComment = pattern.captureIndex("leadingComment");
+    auto collect = [&](const vector<myRegexRange>& capt) {
+        if (capt[ixComment].begin() == capt[ixComment].end())
+            decls.push_back(capt);
+    };
+    if (myRegexBase::getEngine() == myRegexBase::ENGINE_NFA) {
+        // VM program compiled at build time
+        static constexpr myRegexNfaCt<2 * pattern.len + 8, pattern.len + 1> prog(pattern.expr, pattern.len);
+        static const myRegexNfa nfa(prog.getProgram());
+        body.forEachMatch(nfa, anchors, collect);
+    } else {
+        // common prefixes of alternatives factored out: less backtracking. Same captures
+        static const myRegexBase factored = myRegexBase(pattern).optimized(pattern.getNames());
+        assert(factored.getNames() == pattern.getNames());
+        static const std::regex& reg = regexRegistry::get(factored.getExpr());
+        body.forEachMatch(reg, anchors, collect);
+    }
+    return decls;
+}
+
+MHPP("public")
+// scan() via the cache, if enabled (may run on worker thread)
+std::vector<std::vector<myRegexRange>> codeGen::scanCached(const myRegexRange& body) {
+    vector<vector<myRegexRange>> capt;
+    if (cache && cache->lookup(body, capt))
+        return capt;
+    capt = scan(body);
+    if (cache)
+        cache->store(body, capt);
+    return capt;
 }
 
 MHPP("public")
@@ -30,28 +206,42 @@ void codeGen::pass2(const std::string& fname, bool clean) {
     // === retrieve original file contents ===
     auto it = filebodyByFilename.find(fname);
     assert(it != filebodyByFilename.end());
-    const myRegexRange& all = it->second;
-    // === break into nonmatch|match|nonmatch|...|nonmatch stream ===
-    myAppRegex rx = myAppRegex::MHPP_begin();
-    vector<myRegexRange> nonCapt;
-    vector<map<string, myRegexRange>> capt;
-    all.splitByMatches(rx, nonCapt, capt);
+    const myRegexRange& all = *it->second;
+    if (!hasMarker(all.begin(), all.end())) {
+        // no MHPP("begin ...") sections
+        std::lock_guard<std::mutex> lock(mtx);
+        sectionsByFilename[fname] = vector<string>();
+        return;
+    }
+    // === collect MHPP("begin ...")...MHPP("end ...") sections ===
+    // dedicated scanner: sections may be megabytes long
+    vector<vector<myRegexRange>> capt;
+    sectionScanner::forEachSection(all, [&](const vector<myRegexRange>& c) { capt.push_back(c); });
+    static const size_t ixClassname1 = sectionScanner::pattern().captureIndex("classname1");
+    vector<string> sections;
+    for (const auto& c : capt)
+        sections.push_back(c[ixClassname1].str());
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        sectionsByFilename[fname] = sections;
+    }
 
     // === replace old file content between MHPP ("begin classname")...MHPP ("end classname") with respective classname's declarations ===
-    const size_t nCapt = capt.size();
-    if (nCapt == 0)
+    if (capt.size() == 0)
         return;
-    assert(nonCapt.size() == nCapt + 1);  // implies > 0
     string res;
-    for (size_t ixMatch = 0; ixMatch < nCapt; ++ixMatch) {
-        res += nonCapt[ixMatch].str();
-        res += MHPP_begin(capt[ixMatch], clean);
+    const char* cursor = all.begin();  // end of previous section
+    for (const auto& c : capt) {
+        res.append(cursor, c[0].begin());
+        res += MHPP_begin(c, clean);
+        cursor = c[0].end();
     }
-    res += nonCapt[nCapt].str();
+    res.append(cursor, all.end());
 
     // === replace in-memory file contents (but don't write yet) ===
     if (all.str() != res) {
         // contents did change
+        std::lock_guard<std::mutex> lock(mtx);
         auto r2 = fileRewriteByName.find(fname);
         assert(r2 == fileRewriteByName.end());
         auto r3 = fileRewriteByName.insert({fname, res});
@@ -59,48 +249,129 @@ void codeGen::pass2(const std::string& fname, bool clean) {
     }
 }
 
+MHPP("public")
+// pass2 over all files, distributed over the pool
+void codeGen::pass2(const std::vector<std::string>& fnames, bool clean, workerPool& pool) {
+    pool.run(fnames.size(), [&](size_t ix) { pass2(fnames[ix], clean); });
+}
+
 MHPP("public")
 void codeGen::pass3(const std::string& fname) {
     auto it = fileRewriteByName.find(fname);
     if (it == fileRewriteByName.end())
         return;
-    string all = it->second;
+    const string& all = it->second;
 #if true
-    std::ofstream(fname, std::ios::binary) << all;
+    writeFileAtomic(fname, all);
 #else
     cout << "===" << fname << "===" << endl
          << all;
 #endif
 }
 
-MHPP("private static")
-std::string codeGen::namedCaptAsString(const std::string& name, const std::map<std::string, myRegexRange> capt) {
-    return namedCaptAsRange(name, capt).str();
+MHPP("public")
+// pass3 over all files, distributed over the pool
+void codeGen::pass3(const std::vector<std::string>& fnames, workerPool& pool) {
+    pool.run(fnames.size(), [&](size_t ix) { pass3(fnames[ix]); });
+}
+
+MHPP("private")
+// pass1 read and scan with batched reading: files are read in a separate thread, each is scanned on the pool as soon as it arrives
+void codeGen::scanBatchRead(const std::vector<std::string>& fnames, bool clean, workerPool& pool, std::vector<myRegexRange::root_t>& bodies, std::vector<std::vector<std::vector<myRegexRange>>>& decls) {
+    std::mutex mtxIngest;
+    std::condition_variable cvIngest;
+    bool ingestDone = false;
+    std::exception_ptr ingestError;
+    std::thread reader([&]() {
+        try {
+            fileIngest::readAll(fnames, [&](size_t ix, string&& contents) {
+                myRegexRange::root_t body = myRegexRange::own(std::move(contents), fnames[ix]);
+                std::lock_guard<std::mutex> lock(mtxIngest);
+                bodies[ix] = std::move(body);
+                cvIngest.notify_all();
+            });
+        } catch (...) {
+            ingestError = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mtxIngest);
+        ingestDone = true;
+        cvIngest.notify_all();
+    });
+
+    try {
+        pool.run(fnames.size(), [&](size_t ix) {
+            {
+                std::unique_lock<std::mutex> lock(mtxIngest);
+                cvIngest.wait(lock, [&] { return bodies[ix] || ingestDone; });
+                if (!bodies[ix]) return;  // read failure, reported by reader
+            }
+            if (!clean)
+                decls[ix] = scanCached(*bodies[ix]);
+        });
+    } catch (...) {
+        reader.join();
+        throw;
+    }
+    reader.join();
+    if (ingestError) std::rethrow_exception(ingestError);
+}
+
+MHPP("private")
+// registers file contents and collects declarations from its scan() result
+void codeGen::addFile(const std::string& fname, myRegexRange::root_t&& body, const std::vector<std::vector<myRegexRange>>& decls) {
+    auto r = filebodyByFilename.insert({fname, std::move(body)});
+    if (!r.second) throw runtime_error("duplicate filename: '" + fname + "'");
+    declsByFilename[fname] = decls;
+    filenameOrder.push_back(fname);
+    currentSource = fname;
+    for (const auto& a : decls)
+        MHPP_classitem(a);
+    currentSource.clear();
+}
+
+MHPP("private")
+// scans new contents of known files on the pool and replaces their stored contents and scan() results (resident mode)
+void codeGen::rescan(const std::vector<std::string>& fnames, std::vector<myRegexRange::root_t>& bodies, workerPool& pool) {
+    vector<vector<vector<myRegexRange>>> decls(fnames.size());
+    pool.run(fnames.size(), [&](size_t ix) { decls[ix] = scanCached(*bodies[ix]); });
+    for (size_t ix = 0; ix < fnames.size(); ++ix)
+        replaceFile(fnames[ix], std::move(bodies[ix]), decls[ix]);
+}
+
+MHPP("private")
+// replaces contents and scan() result of a known file (resident mode)
+void codeGen::replaceFile(const std::string& fname, myRegexRange::root_t&& body, const std::vector<std::vector<myRegexRange>>& decls) {
+    auto it = filebodyByFilename.find(fname);
+    if (it == filebodyByFilename.end()) throw runtime_error("'" + fname + "' is not one of the processed files");
+    declsByFilename[fname] = decls;
+    it->second = std::move(body);  // releases the old contents
 }
 
 MHPP("private static")
-myRegexRange codeGen::namedCaptAsRange(const std::string& name, const std::map<std::string, myRegexRange> capt) {
-    auto it = capt.find(name);
-    if (it == capt.end())
-        throw runtime_error("regex result does not contain named capture '" + name + "'");
-    return it->second;
+// escapes a filename for make/ninja dependency files
+std::string codeGen::depfileEscape(const std::string& fname) {
+    string res;
+    for (char c : fname) {
+        if ((c == ' ') || (c == '#') || (c == '\\'))
+            res += '\\';
+        else if (c == '$')
+            res += '$';
+        res += c;
+    }
+    return res;
 }
 
 MHPP("public")
 // called on declaration regex capture declaration
-void codeGen::MHPP_classitem(const std::map<std::string, myRegexRange> capt) {
-    const string leadingComment = namedCaptAsString("leadingComment", capt);
-    bool isComment = leadingComment.size() > 0;
-    if (isComment) {
-        return;
-    }
+void codeGen::MHPP_classitem(const std::vector<myRegexRange>& capt) {
 #if false
-    cout << "=== non-comment classitem ===" << endl;
-    for (auto x : capt) cout << x.first << "\t>>>" << x.second.str() << "<<<" << endl;
+    cout << "=== classitem ===" << endl;
+    for (const auto& x : capt) cout << ">>>" << x.str() << "<<<" << endl;
 #endif
-
-    const string fun_keyword = namedCaptAsString("fun_MHPP_keyword", capt);
-    const string var_keyword = namedCaptAsString("var_MHPP_keyword", capt);
+    static constexpr size_t ixFunKeyword = myAppRegexCt::scanDecl.captureIndex("fun_MHPP_keyword");
+    static constexpr size_t ixVarKeyword = myAppRegexCt::scanDecl.captureIndex("var_MHPP_keyword");
+    const string fun_keyword = capt[ixFunKeyword].str();
+    const string var_keyword = capt[ixVarKeyword].str();
     bool isFun = fun_keyword.size() > 0;
     bool isVar = var_keyword.size() > 0;
 
@@ -113,10 +384,13 @@ void codeGen::MHPP_classitem(const std::map<std::string, myRegexRange> capt) {
 }
 
 MHPP("public")
-std::string codeGen::MHPP_begin(const std::map<std::string, myRegexRange>& capt, bool clean) {
-    const string indent = namedCaptAsString("indent", capt);
-    const string classname1 = namedCaptAsString("classname1", capt);
-    const string classname2 = namedCaptAsString("classname2", capt);
+std::string codeGen::MHPP_begin(const std::vector<myRegexRange>& capt, bool clean) {
+    static const size_t ixIndent = sectionScanner::pattern().captureIndex("indent");
+    static const size_t ixClassname1 = sectionScanner::pattern().captureIndex("classname1");
+    static const size_t ixClassname2 = sectionScanner::pattern().captureIndex("classname2");
+    const string indent = capt[ixIndent].str();
+    const string classname1 = capt[ixClassname1].str();
+    const string classname2 = capt[ixClassname2].str();
     if (classname1 != classname2) throw runtime_error("MHPP(\"begin " + classname1 + "\") terminated by MHPP(\"end " + classname2 + ")\"");
 
     string indentp1 = indent + "\t";
@@ -127,10 +401,13 @@ std::string codeGen::MHPP_begin(const std::map<std::string, myRegexRange>& capt,
         if (itc == classesByName.end()) throw runtime_error("no data for MHPP(\"begin " + classname1 + "\")");
 
         // === sanity check that each class has only one AHBEGIN(classname)...AHEND section ===
-        auto r2 = classDone.find(classname1);
-        assert(r2 != classDone.end());
-        if (r2->second) throw runtime_error("duplicate MHPP(\"begin...end " + classname1 + "\")");
-        r2->second = true;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto r2 = classDone.find(classname1);
+            assert(r2 != classDone.end());
+            if (r2->second) throw runtime_error("duplicate MHPP(\"begin...end " + classname1 + "\")");
+            r2->second = true;
+        }
 
         const oneClass& c = itc->second;
         const string pubTxt = c.getPublicText(indentp1);
@@ -150,6 +427,29 @@ std::string codeGen::MHPP_begin(const std::map<std::string, myRegexRange>& capt,
     return res;
 }
 
+MHPP("public")
+// make/ninja dependency rules: each file with MHPP("begin ...") sections depends on the files contributing declarations to them
+std::string codeGen::depfileRules() const {
+    string res;
+    for (const string& fname : filenameOrder) {
+        auto its = sectionsByFilename.find(fname);
+        if ((its == sectionsByFilename.end()) || (its->second.size() == 0))
+            continue;
+        std::set<string> sources;
+        for (const string& classname : its->second) {
+            auto itc = sourcesByClass.find(classname);
+            if (itc != sourcesByClass.end())
+                sources.insert(itc->second.begin(), itc->second.end());
+        }
+        sources.erase(fname);  // no self-dependency
+        res += depfileEscape(fname) + ":";
+        for (const string& src : sources)
+            res += " \\\n " + depfileEscape(src);
+        res += "\n";
+    }
+    return res;
+}
+
 MHPP("public")
 void codeGen::checkAllClassesDone() {
     for (auto it : classDone)
@@ -175,6 +475,8 @@ oneClass& codeGen::getClass(const std::string& classname) {
         auto r2 = classDone.insert({classname, false});
         assert(r2.second);
     }
+    if (currentSource.size() > 0)
+        sourcesByClass[classname].insert(currentSource);
     return itc->second;
 }
 
@@ -202,28 +504,37 @@ string getAnnot(const myRegexRange& r) {
 
 MHPP("protected")
 // called on declaration regex capture that is a function
-void codeGen::MHPP_classfun(const std::map<std::string, myRegexRange> capt) {
-    auto all = namedCaptAsRange("all", capt);
-    auto rkeyword = namedCaptAsRange("fun_MHPP_keyword", capt);
+void codeGen::MHPP_classfun(const std::vector<myRegexRange>& capt) {
+    static constexpr const auto& pattern = myAppRegexCt::scanDecl;
+    static constexpr size_t ixKeyword = pattern.captureIndex("fun_MHPP_keyword");
+    static constexpr size_t ixComment = pattern.captureIndex("fun_comment");
+    static constexpr size_t ixReturntype = pattern.captureIndex("fun_returntype");
+    static constexpr size_t ixClassmethodname = pattern.captureIndex("fun_classmethodname");
+    static constexpr size_t ixArglist = pattern.captureIndex("fun_arglist");
+    static constexpr size_t ixPostArg = pattern.captureIndex("fun_postArg");
+    const myRegexRange& all = capt[0];
+    const myRegexRange& rkeyword = capt[ixKeyword];
     const string keyword = rkeyword.str();
-    auto comment = namedCaptAsString("fun_comment", capt);
-    auto returntype = namedCaptAsString("fun_returntype", capt);
-    auto rclassmethodname = namedCaptAsRange("fun_classmethodname", capt);
+    auto comment = capt[ixComment].str();
+    auto returntype = capt[ixReturntype].str();
+    const myRegexRange& rclassmethodname = capt[ixClassmethodname];
     const string classmethodname = rclassmethodname.str();
-    auto arglist = namedCaptAsString("fun_arglist", capt);
-    auto postArg = namedCaptAsString("fun_postArg", capt);
+    auto arglist = capt[ixArglist].str();
+    auto postArg = capt[ixPostArg].str();
     assert(keyword.size() > 0);
 
     // parse classname::methodname
-    myAppRegex rcm = myAppRegex::classMethodname();
-    map<string, myRegexRange> cm;
+    static const myAppRegex rcm = myAppRegex::classMethodname();
+    static constexpr size_t ixClassname = myAppRegexCt::classMethodname.captureIndex("classname");
+    static constexpr size_t ixMethodname = myAppRegexCt::classMethodname.captureIndex("methodname");
+    vector<myRegexRange> cm;
     if (!rclassmethodname.match(rcm, cm)) {
-        for (auto x : capt) cout << x.first << "\t>>>" << x.second.str() << "<<<" << endl;
+        for (const auto& x : capt) cout << ">>>" << x.str() << "<<<" << endl;
         throw runtime_error("'" + classmethodname + "' is not of the expected format classname::(classname...)::methodname");
     }
 
-    const string classname = namedCaptAsString("classname", cm);
-    const string methodname = namedCaptAsString("methodname", cm);
+    const string classname = cm[ixClassname].str();
+    const string methodname = cm[ixMethodname].str();
     // build output line
     vector<string> destText;
     if (annotate) {
@@ -257,19 +568,17 @@ void codeGen::MHPP_classfun(const std::map<std::string, myRegexRange> capt) {
     c.addTextByKeyword(keyword, destText, /*for error message*/ classmethodname);
 
     // search for altclass=xyz
-    myAppRegex rAltCapt = myAppRegex::rx("altclass=") + myAppRegex::capture("altclass", myAppRegex::rx("[a-zA-Z0-9_:]+"));
-    vector<myRegexRange> altclassNonCapt;
-    vector<map<string, myRegexRange>> altclassCapt;
-    rkeyword.splitByMatches(rAltCapt, altclassNonCapt, altclassCapt);
-    for (auto altclassMatch : altclassCapt) {
+    static const myAppRegex rAltCapt = myAppRegex::rx("altclass=") + myAppRegex::capture("altclass", myAppRegex::rx("[a-zA-Z0-9_:]+"));
+    static const size_t ixAltclass = rAltCapt.captureIndex("altclass");
+    rkeyword.forEachMatch(rAltCapt, [&](const vector<myRegexRange>& altclassMatch) {
         if (isStatic) throw runtime_error(getAnnot(rkeyword) + " An altclass-tagged method cannot be static");
         if (!isVirtual) throw runtime_error(getAnnot(rkeyword) + " An altclass-tagged method needs to be virtual");
-        const string altClass = namedCaptAsString("altclass", altclassMatch);
+        const string altClass = altclassMatch[ixAltclass].str();
         oneClass& cAlt = getClass(altClass);
         cAlt.addTextByKeyword("public", destText, /*for error message*/ classmethodname);
-    }
+    });
 
-    auto rx = regex("pImpl=([_a-zA-Z0-9:]+)");
+    const regex& rx = regexRegistry::get("pImpl=([_a-zA-Z0-9:]+)");
     std::sregex_iterator itp(keyword.cbegin(), keyword.cend(), rx);
     std::sregex_iterator itEnd;
     while (itp != itEnd) {
@@ -283,25 +592,32 @@ void codeGen::MHPP_classfun(const std::map<std::string, myRegexRange> capt) {
 
 MHPP("protected")
 // called on declaration regex capture that is a static variable
-void codeGen::MHPP_classvar(const std::map<std::string, myRegexRange> capt) {
-    const auto all = namedCaptAsRange("all", capt);
-    const auto keyword = namedCaptAsString("var_MHPP_keyword", capt);
-    auto comment = namedCaptAsString("var_comment", capt);
-    const auto returntype = namedCaptAsString("var_returntype", capt);
-    const auto rclassvarname = namedCaptAsRange("var_classvarname", capt);
+void codeGen::MHPP_classvar(const std::vector<myRegexRange>& capt) {
+    static constexpr const auto& pattern = myAppRegexCt::scanDecl;
+    static constexpr size_t ixKeyword = pattern.captureIndex("var_MHPP_keyword");
+    static constexpr size_t ixComment = pattern.captureIndex("var_comment");
+    static constexpr size_t ixReturntype = pattern.captureIndex("var_returntype");
+    static constexpr size_t ixClassvarname = pattern.captureIndex("var_classvarname");
+    const myRegexRange& all = capt[0];
+    const auto keyword = capt[ixKeyword].str();
+    auto comment = capt[ixComment].str();
+    const auto returntype = capt[ixReturntype].str();
+    const myRegexRange& rclassvarname = capt[ixClassvarname];
     const auto classvarname = rclassvarname.str();
     assert(keyword.size() > 0);
 
     // parse classname::varname
-    myAppRegex rcm = myAppRegex::classMethodname();  // reusing regex
-    map<string, myRegexRange> cm;
+    static const myAppRegex rcm = myAppRegex::classMethodname();  // reusing regex
+    static constexpr size_t ixClassname = myAppRegexCt::classMethodname.captureIndex("classname");
+    static constexpr size_t ixVarname = myAppRegexCt::classMethodname.captureIndex("methodname");
+    vector<myRegexRange> cm;
     if (!rclassvarname.match(rcm, cm)) {
-        for (auto x : capt) cout << x.first << "\t>>>" << x.second.str() << "<<<" << endl;
+        for (const auto& x : capt) cout << ">>>" << x.str() << "<<<" << endl;
         throw runtime_error("'" + classvarname + "' is not of the expected format classname::(classname...)::varname");
     }
 
-    const auto classname = namedCaptAsString("classname", cm);
-    const auto varname = namedCaptAsString("methodname", cm);
+    const auto classname = cm[ixClassname].str();
+    const auto varname = cm[ixVarname].str();
 
     // build output line
     vector<string> destText;
@@ -325,59 +641,104 @@ void codeGen::MHPP_classvar(const std::map<std::string, myRegexRange> capt) {
     c.addTextByKeyword(keyword, destText, classvarname);
 }
 
-MHPP("protected static")
-std::string codeGen::readFile(const std::string& fname) {
-    std::ostringstream oss;
-    auto s = std::ifstream(fname, std::ios::binary);
-    if (!s) throw runtime_error("failed to read '" + fname + "'");
-    oss << std::ifstream(fname, std::ios::binary).rdbuf();
-    return oss.str();
+MHPP("public static")
+// writes to a temporary file in the same directory, then renames over fname (a killed run leaves either old or new contents)
+void codeGen::writeFileAtomic(const std::string& fname, const std::string& contents) {
+    const string tmpName = fname + ".makeheaderspp.tmp";
+    {
+        std::ofstream s(tmpName, std::ios::binary);
+        if (!s) throw runtime_error("failed to open '" + tmpName + "' for writing");
+        s << contents;
+        s.close();
+        if (!s) {
+            std::remove(tmpName.c_str());
+            throw runtime_error("failed to write '" + tmpName + "'");
+        }
+    }
+
+    // === keep permissions of the original file ===
+    std::error_code ec;
+    const auto perms = std::filesystem::status(fname, ec).permissions();
+    if (!ec)
+        std::filesystem::permissions(tmpName, perms, ec);
+
+    if (std::rename(tmpName.c_str(), fname.c_str()) != 0) {
+        std::remove(tmpName.c_str());
+        throw runtime_error("failed to replace '" + fname + "'");
+    }
 }
 
 MHPP("private static")
-// converts "(int x, map<string, int>y)" to {"x", "y"}
+// converts "(int x, map<string, int>y)" to {"x", "y"}. Single pass over the bracket structure from regionized: commas separate arguments only outside nested
+// brackets, quotes and comments. The name is the last identifier of each argument. Comments and template <> count as whitespace (the name may follow immediately after >)
 std::vector<std::string> codeGen::arglist2names(const std::string& arglist) {
-    vector<string> ret;
-    std::smatch m;
-
-    // remove outer round brackets, trim
-    if (!std::regex_match(arglist, m, regex("^"
-                                            "\\s*"
-                                            "\\("
-                                            "(.*)"
-                                            "\\)"
-                                            "\\s*"
-                                            "$")))
+    const regionized parsed(arglist.cbegin(), arglist.cend());
+    const vector<regionized::region>& regions = parsed.getRegions();
+    auto isSpace = [](char c) { return std::isspace((unsigned char)c) != 0; };
+    const csit_t itFirst = std::find_if_not(arglist.cbegin(), arglist.cend(), isSpace);
+    const csit_t itLast = std::find_if_not(arglist.crbegin(), arglist.crend(), isSpace).base();
+
+    // === outer round brackets: the only region on level 1, spanning the trimmed arglist. Direct children on level 2 (in order, as siblings are inserted at their end) ===
+    size_t nOuter = 0;
+    bool isBracketed = false;
+    vector<size_t> ixNested;
+    for (size_t ix = 0; ix < regions.size(); ++ix) {
+        const regionized::region& r = regions[ix];
+        if (r.getLevel() == 1) {
+            ++nOuter;
+            isBracketed = (r.getRType() == regionized::BRK_RND) && (r.getBegin() == itFirst) && (r.getEnd() == itLast) && (*(itLast - 1) == ')');
+        } else if (r.getLevel() == 2) {
+            if (r.getEnd() == itLast) isBracketed = false;  // unterminated: closing bracket belongs to nested region
+            ixNested.push_back(ix);
+        }
+    }
+    if ((nOuter != 1) || !isBracketed)
         throw runtime_error("pimpl failed to match arglist brackets in '" + arglist + "'");
-    assert(m.size() == 2);
-    string arglistPImpl = m[1];
-    if (arglistPImpl.size() == 0) return ret;  // split below will return nSep+1 results => empty string would cause "" capture
-
-    arglistPImpl = myAppRegex::replaceAll(arglistPImpl, regex("/\\*"
-                                                              "[^\\*]*"
-                                                              "\\*/"),
-                                          " ");  // replace C++ comments with whitespace
-    arglistPImpl = myAppRegex::replaceAll(arglistPImpl, regex("<"
-                                                              "[^<>]*"
-                                                              ">"),
-                                          " ");  // replace template <> with whitespace (as the name may follow immediately after >)
-
-    // note: after removal of template args, remaining commas separate args
-    vector<string> argsPImpl = myAppRegex::split(arglistPImpl, regex(","));
-    for (const string& a : argsPImpl) {
-        if (!std::regex_match(a, m, regex("^"
-                                          ".*?"
-                                          "("
-                                          "[_a-zA-Z][_a-zA-Z0-9]*"
-                                          ")"
-                                          "\\s*"
-                                          "$")))
-            throw runtime_error("pimpl failed to match arg: '" + a + "' in '" + arglist + "'");
-        assert(m.size() == 2);
-        ret.push_back(m[1]);
+    const csit_t argsEnd = itLast - 1;
+
+    // === tokenize arguments ===
+    vector<string> ret;
+    csit_t argBegin = itFirst + 1;
+    string name;               // last identifier in current argument
+    bool nameIsLast = false;   // no other token followed the name
+    bool isEmptyArg = true;    // only whitespace so far
+    size_t ixNext = 0;         // next nested region
+    csit_t it = argBegin;
+    while (true) {
+        if ((it == argsEnd) || (*it == ',')) {
+            if ((it == argsEnd) && isEmptyArg && (ret.size() == 0)) break;  // ()
+            if (!nameIsLast) throw runtime_error("pimpl failed to match arg: '" + string(argBegin, it) + "' in '" + arglist + "'");
+            ret.push_back(name);
+            if (it == argsEnd) break;
+            argBegin = ++it;
+            nameIsLast = false;
+            isEmptyArg = true;
+            continue;
+        }
+        if ((ixNext < ixNested.size()) && (it == regions[ixNested[ixNext]].getBegin())) {
+            const regionized::region& r = regions[ixNested[ixNext++]];
+            const regionized::rType_e t = r.getRType();
+            if ((t != regionized::REM_C) && (t != regionized::REM_CPP) && (t != regionized::BRK_ANG)) {
+                nameIsLast = false;
+                isEmptyArg = false;
+            }
+            it = r.getEnd();
+            continue;
+        }
+        isEmptyArg = isEmptyArg && isSpace(*it);
+        if ((*it == '_') || std::isalnum((unsigned char)*it)) {
+            // identifier or number
+            const csit_t tokBegin = it;
+            const csit_t tokLimit = (ixNext < ixNested.size()) ? regions[ixNested[ixNext]].getBegin() : argsEnd;  // e.g. L"..."
+            while ((it != tokLimit) && ((*it == '_') || std::isalnum((unsigned char)*it)))
+                ++it;
+            nameIsLast = !std::isdigit((unsigned char)*tokBegin);
+            name.assign(tokBegin, it);
+            continue;
+        }
+        if (!isSpace(*it)) nameIsLast = false;
+        ++it;
     }
-    // for (size_t ix = 0; ix < ret.size(); ++ix)
-    //    cout << ix << "\t" << ret[ix] << endl;
     return ret;
 }
 
@@ -1,40 +1,99 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>  // memchr
+#include <cstdio>  // rename
+#include <filesystem>
 #include <fstream>  // ifstream
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
+#include "fileIngest.h"
 #include "myAppRegex.h"
+#include "myRegexNfa.h"
+#include "myRegexNfaCompiler.h"
 #include "myRegexRange.h"
 #include "oneClass.h"
+#include "regexRegistry.h"
+#include "regionized.h"
+#include "scanCache.h"
+#include "sectionScanner.h"
+#include "workerPool.h"
 class codeGen {
+   public:
+    // how pass1 obtains file contents
+    typedef enum {
+        // read each file into memory
+        INPUT_READ,
+        // map each file read-only into memory
+        INPUT_MMAP,
+        // read all files in batches (io_uring where available), overlapping with scanning
+        INPUT_BATCHREAD
+    } inputMode_e;
     MHPP("begin codeGen") // === autogenerated code. Do not edit ===
     public:
-    	codeGen(bool annotate);
+    	codeGen(bool annotate, inputMode_e inputMode);
     	void pass1(const std::string& fname, bool clean);
+    	// pass1 over all files. Reading and scanning is distributed over the pool, results are merged in argument order
+    	void pass1(const std::vector<std::string>& fnames, bool clean, workerPool& pool);
+    	// resident mode: re-reads changed files and rewrites files whose MHPP("begin ...") sections change as a result. Returns written files.
+    	// The first call processes all files. Rewritten files are rescanned from their new contents for the next call
+    	std::vector<std::string> regenerate(const std::vector<std::string>& changed, workerPool& pool);
+    	// looks up scan() results in directory dir before scanning, stores new results there
+    	void useCache(const std::string& dir);
+    	// reads file contents, optionally as read-only memory mapping
+    	static myRegexRange::root_t load(const std::string& fname, inputMode_e inputMode);
+    	// true if text contains "MHPP". Skips with memchr to candidate positions
+    	static bool hasMarker(const char* begin, const char* end);
+    	// regex search for tagged definitions. Does not access codeGen state (may run on worker thread)
+    	static std::vector<std::vector<myRegexRange>> scan(const myRegexRange& body);
+    	// scan() via the cache, if enabled (may run on worker thread)
+    	std::vector<std::vector<myRegexRange>> scanCached(const myRegexRange& body);
     	void pass2(const std::string& fname, bool clean);
+    	// pass2 over all files, distributed over the pool
+    	void pass2(const std::vector<std::string>& fnames, bool clean, workerPool& pool);
     	void pass3(const std::string& fname);
+    	// pass3 over all files, distributed over the pool
+    	void pass3(const std::vector<std::string>& fnames, workerPool& pool);
     	// called on declaration regex capture declaration
-    	void MHPP_classitem(const std::map<std::string, myRegexRange> capt);
-    	std::string MHPP_begin(const std::map<std::string, myRegexRange>& capt, bool clean);
+    	void MHPP_classitem(const std::vector<myRegexRange>& capt);
+    	std::string MHPP_begin(const std::vector<myRegexRange>& capt, bool clean);
+    	// make/ninja dependency rules: each file with MHPP("begin ...") sections depends on the files contributing declarations to them
+    	std::string depfileRules() const;
     	void checkAllClassesDone();
+    	// writes to a temporary file in the same directory, then renames over fname (a killed run leaves either old or new contents)
+    	static void writeFileAtomic(const std::string& fname, const std::string& contents);
     protected:
     	bool hasClass(const std::string& classname);
     	oneClass& getClass(const std::string& classname);
     	static std::string trimNewline(std::string& text);
     	// called on declaration regex capture that is a function
-    	void MHPP_classfun(const std::map<std::string, myRegexRange> capt);
+    	void MHPP_classfun(const std::vector<myRegexRange>& capt);
     	// called on declaration regex capture that is a static variable
-    	void MHPP_classvar(const std::map<std::string, myRegexRange> capt);
-    	static std::string readFile(const std::string& fname);
+    	void MHPP_classvar(const std::vector<myRegexRange>& capt);
     	static std::string join(const std::vector<std::string>& v, const std::string& delim);
     private:
-    	static std::string namedCaptAsString(const std::string& name, const std::map<std::string, myRegexRange> capt);
-    	static myRegexRange namedCaptAsRange(const std::string& name, const std::map<std::string, myRegexRange> capt);
-    	// converts "(int x, map<string, int>y)" to {"x", "y"}
+    	// regenerate() for files whose contents changed. isFirst: process all files
+    	std::vector<std::string> regenerateModified(const std::vector<std::string>& modified, std::vector<myRegexRange::root_t>& modifiedBodies, bool isFirst, workerPool& pool);
+    	// pass1 read and scan with batched reading: files are read in a separate thread, each is scanned on the pool as soon as it arrives
+    	void scanBatchRead(const std::vector<std::string>& fnames, bool clean, workerPool& pool, std::vector<myRegexRange::root_t>& bodies, std::vector<std::vector<std::vector<myRegexRange>>>& decls);
+    	// registers file contents and collects declarations from its scan() result
+    	void addFile(const std::string& fname, myRegexRange::root_t&& body, const std::vector<std::vector<myRegexRange>>& decls);
+    	// scans new contents of known files on the pool and replaces their stored contents and scan() results (resident mode)
+    	void rescan(const std::vector<std::string>& fnames, std::vector<myRegexRange::root_t>& bodies, workerPool& pool);
+    	// replaces contents and scan() result of a known file (resident mode)
+    	void replaceFile(const std::string& fname, myRegexRange::root_t&& body, const std::vector<std::vector<myRegexRange>>& decls);
+    	// escapes a filename for make/ninja dependency files
+    	static std::string depfileEscape(const std::string& fname);
+    	// converts "(int x, map<string, int>y)" to {"x", "y"}. Single pass over the bracket structure from regionized: commas separate arguments only outside nested
+    	// brackets, quotes and comments. The name is the last identifier of each argument. Comments and template <> count as whitespace (the name may follow immediately after >)
     	static std::vector<std::string> arglist2names(const std::string& arglist);
     	void generatePImpl(const std::string& classname,
     	                            const std::string& retType,
@@ -44,10 +103,29 @@ class codeGen {
     	                            const std::string& postArgs);
     MHPP("end codeGen")
    private:
+    codeGen(const codeGen&) = delete;
+    codeGen& operator=(const codeGen&) = delete;
     std::map<std::string, oneClass> classesByName;
     std::map<std::string, bool> classDone;
-    std::map<std::string, myRegexRange> filebodyByFilename;
+    // file contents, owned (released with codeGen)
+    std::map<std::string, myRegexRange::root_t> filebodyByFilename;
+    // scan() result by file, kept for regenerate()
+    std::map<std::string, std::vector<std::vector<myRegexRange>>> declsByFilename;
+    // files in order of pass1 (argument order)
+    std::vector<std::string> filenameOrder;
+    // files contributing declarations by classname (for --depfile)
+    std::map<std::string, std::set<std::string>> sourcesByClass;
+    // file whose declarations are being collected (recorded in sourcesByClass by getClass)
+    std::string currentSource;
+    // classnames of MHPP("begin ...") sections by file, from pass2
+    std::map<std::string, std::vector<std::string>> sectionsByFilename;
     std::map<std::string, std::string> fileRewriteByName;
+    // guards classDone, fileRewriteByName and sectionsByFilename in pass2 (may run on worker threads)
+    std::mutex mtx;
 	// -annotate command line flag
     bool annotate;
+    // -mmap / -batchread command line flags
+    inputMode_e inputMode;
+    // --cache command line option (null if not given)
+    std::unique_ptr<scanCache> cache;
 };
@@ -0,0 +1,98 @@
+#include "dirScan.h"
+
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>  // memchr, memcmp
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+
+#include "codeGen.h"
+using std::string, std::vector, std::runtime_error;
+namespace fs = std::filesystem;
+
+MHPP("public static")
+// files below dir (sorted) matching any of includes (all C/C++ sources and headers if empty) and none of excludes, that contain an MHPP marker.
+// Patterns are shell wildcards, matched against the filename and the path relative to dir
+std::vector<std::string> dirScan::collect(const std::string& dir, const std::vector<std::string>& includes, const std::vector<std::string>& excludes, workerPool& pool) {
+    if (!fs::is_directory(dir)) throw runtime_error("-r: '" + dir + "' is not a directory");
+    static const vector<string> defaultIncludes = {"*.h", "*.hh", "*.hpp", "*.hxx", "*.c", "*.cc", "*.cpp", "*.cxx"};
+    const vector<string>& inc = includes.size() > 0 ? includes : defaultIncludes;
+
+    // === traverse level by level, listing all directories of a level in parallel ===
+    vector<string> candidates;
+    vector<string> level = {dir};
+    std::mutex mtx;
+    while (level.size() > 0) {
+        vector<string> nextLevel;
+        pool.run(level.size(), [&](size_t ix) {
+            vector<string> files;
+            vector<string> subdirs;
+            std::error_code ec;
+            for (fs::directory_iterator it(level[ix], ec), itEnd; !ec && (it != itEnd); it.increment(ec)) {
+                const fs::path& p = it->path();
+                const string rel = p.lexically_relative(dir).string();
+                if (matchesAny(excludes, p.filename().string(), rel))
+                    continue;
+                std::error_code ecType;
+                if (it->is_directory(ecType) && !it->is_symlink(ecType))
+                    subdirs.push_back(p.string());
+                else if (it->is_regular_file(ecType) && matchesAny(inc, p.filename().string(), rel))
+                    files.push_back(p.string());
+            }
+            if (ec) throw runtime_error("-r: failed to list '" + level[ix] + "'");
+            std::lock_guard<std::mutex> lock(mtx);
+            candidates.insert(candidates.end(), files.begin(), files.end());
+            nextLevel.insert(nextLevel.end(), subdirs.begin(), subdirs.end());
+        });
+        level = nextLevel;
+    }
+
+    // === drop files without marker, before any parsing ===
+    vector<char> keep(candidates.size(), 0);
+    pool.run(candidates.size(), [&](size_t ix) { keep[ix] = mayContainMarker(candidates[ix]); });
+    vector<string> res;
+    for (size_t ix = 0; ix < candidates.size(); ++ix)
+        if (keep[ix]) res.push_back(candidates[ix]);
+
+    // === deterministic order (declaration order within a class follows file order) ===
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+MHPP("private static")
+// true if fname or rel matches one of the shell wildcard patterns
+bool dirScan::matchesAny(const std::vector<std::string>& patterns, const std::string& fname, const std::string& rel) {
+    for (const string& pattern : patterns)
+        if ((::fnmatch(pattern.c_str(), fname.c_str(), 0) == 0) || (::fnmatch(pattern.c_str(), rel.c_str(), FNM_PATHNAME) == 0))
+            return true;
+    return false;
+}
+
+MHPP("private static")
+// false if the file is readable and does not contain "MHPP". Unreadable files are kept (pass1 reports the error)
+bool dirScan::mayContainMarker(const std::string& fname) {
+    const int fd = ::open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return true;
+    struct stat st;
+    if ((::fstat(fd, &st) != 0) || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return true;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return true;
+    const char* begin = static_cast<const char*>(p);
+    const bool r = codeGen::hasMarker(begin, begin + st.st_size);
+    ::munmap(p, st.st_size);
+    return r;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "workerPool.h"
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// finds input files for -r: recursive directory traversal on the pool, filtering by include/exclude patterns and by presence of an MHPP marker
+class dirScan {
+    MHPP("begin dirScan") // === autogenerated code. Do not edit ===
+    public:
+    	// files below dir (sorted) matching any of includes (all C/C++ sources and headers if empty) and none of excludes, that contain an MHPP marker.
+    	// Patterns are shell wildcards, matched against the filename and the path relative to dir
+    	static std::vector<std::string> collect(const std::string& dir, const std::vector<std::string>& includes, const std::vector<std::string>& excludes, workerPool& pool);
+    private:
+    	// true if fname or rel matches one of the shell wildcard patterns
+    	static bool matchesAny(const std::vector<std::string>& patterns, const std::string& fname, const std::string& rel);
+    	// false if the file is readable and does not contain "MHPP". Unreadable files are kept (pass1 reports the error)
+    	static bool mayContainMarker(const std::string& fname);
+    MHPP("end dirScan")
+};
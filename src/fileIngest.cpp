@@ -0,0 +1,304 @@
+#include "fileIngest.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>  // memset
+#endif
+using std::string, std::vector, std::runtime_error, std::exception_ptr;
+
+#ifdef __linux__
+// minimal io_uring submission/completion queue on raw syscalls (no liburing dependency)
+class uringQueue {
+   public:
+    uringQueue(unsigned nEntries) : ringFd(-1), sqRing(nullptr), cqRing(nullptr), sqes(nullptr), sqRingSize(0), cqRingSize(0), sqesSize(0), params() {
+        std::memset(&params, 0, sizeof(params));
+        ringFd = (int)::syscall(__NR_io_uring_setup, nEntries, &params);
+        if (ringFd < 0) return;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            return;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            cqRing = sqRing;
+        } else {
+            cqRing = ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                return;
+            }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* p = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (p == MAP_FAILED) return;
+        sqes = static_cast<io_uring_sqe*>(p);
+    }
+    ~uringQueue() {
+        if (sqes) ::munmap(sqes, sqesSize);
+        if (cqRing && (cqRing != sqRing)) ::munmap(cqRing, cqRingSize);
+        if (sqRing) ::munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) ::close(ringFd);
+    }
+    uringQueue(const uringQueue&) = delete;
+    uringQueue& operator=(const uringQueue&) = delete;
+
+    bool isValid() const { return sqes != nullptr; }
+    unsigned capacity() const { return params.sq_entries; }
+
+    // queues one request (caller limits outstanding requests to capacity())
+    void push(const io_uring_sqe& sqe) {
+        unsigned* tail = field(sqRing, params.sq_off.tail);
+        const unsigned mask = *field(sqRing, params.sq_off.ring_mask);
+        const unsigned t = *tail;  // only written by this thread
+        sqes[t & mask] = sqe;
+        field(sqRing, params.sq_off.array)[t & mask] = t & mask;
+        __atomic_store_n(tail, t + 1, __ATOMIC_RELEASE);
+        ++nUnsubmitted;
+    }
+
+    // submits queued requests, waits for at least one completion. Returns false on failure
+    bool submitAndWait() {
+        while (true) {
+            const int r = (int)::syscall(__NR_io_uring_enter, ringFd, nUnsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r >= 0) {
+                nUnsubmitted -= r;
+                nInFlight += r;
+                return true;
+            }
+            if (errno != EINTR) return false;
+        }
+    }
+
+    // waits for at least one completion without submitting queued requests. Returns false on failure
+    bool wait() {
+        while (true) {
+            if ((int)::syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0) return true;
+            if (errno != EINTR) return false;
+        }
+    }
+
+    // submitted requests whose completion was not yet removed by pop()
+    unsigned inFlight() const { return nInFlight; }
+
+    // removes one completion, if available
+    bool pop(io_uring_cqe& cqe) {
+        unsigned* head = field(cqRing, params.cq_off.head);
+        const unsigned h = *head;  // only written by this thread
+        if (h == __atomic_load_n(field(cqRing, params.cq_off.tail), __ATOMIC_ACQUIRE)) return false;
+        const unsigned mask = *field(cqRing, params.cq_off.ring_mask);
+        cqe = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cqRing) + params.cq_off.cqes)[h & mask];
+        __atomic_store_n(head, h + 1, __ATOMIC_RELEASE);
+        --nInFlight;
+        return true;
+    }
+
+   private:
+    static unsigned* field(void* ring, unsigned offset) { return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset); }
+    int ringFd;
+    void* sqRing;
+    void* cqRing;
+    io_uring_sqe* sqes;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+    io_uring_params params;
+    unsigned nUnsubmitted = 0;
+    unsigned nInFlight = 0;
+};
+#endif
+
+MHPP("public static")
+// reads all files, handing each to sink as it completes. Throws (after all other files were delivered) if a file cannot be read
+void fileIngest::readAll(const std::vector<std::string>& fnames, const sink_t& sink) {
+    if (readAllUring(fnames, sink))
+        return;
+
+    // === fallback ===
+    exception_ptr firstError;
+    for (size_t ix = 0; ix < fnames.size(); ++ix)
+        try {
+            sink(ix, readFile(fnames[ix]));
+        } catch (...) {
+            if (!firstError) firstError = std::current_exception();
+        }
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+MHPP("public static")
+// reads one file with plain stream I/O
+std::string fileIngest::readFile(const std::string& fname) {
+    std::ifstream s(fname, std::ios::binary | std::ios::ate);
+    if (!s) throw runtime_error("failed to read '" + fname + "'");
+    const std::streamoff size = s.tellg();
+    if (size < 0) throw runtime_error("failed to read '" + fname + "'");
+    string r(size, '\0');
+    s.seekg(0);
+    s.read(r.data(), size);
+    if (!s) throw runtime_error("failed to read '" + fname + "'");
+    return r;
+}
+
+MHPP("private static")
+// reads files via io_uring. Returns false if io_uring is unavailable (nothing delivered). Files that fail on io_uring are read with readFile(),
+// as are all remaining files once io_uring itself fails (after its requests in flight completed)
+bool fileIngest::readAllUring(const std::vector<std::string>& fnames, const sink_t& sink) {
+#ifdef __linux__
+    const size_t nFiles = fnames.size();
+    if (nFiles == 0) return true;
+    uringQueue q(256);
+    if (!q.isValid()) return false;
+    const size_t batchSize = q.capacity();
+
+    vector<exception_ptr> errors(nFiles);
+    auto deliver = [&](size_t ix, string&& contents) {
+        try {
+            sink(ix, std::move(contents));
+        } catch (...) {
+            errors[ix] = std::current_exception();
+        }
+    };
+    // delivers file ix the conventional way (which reports the error, if any)
+    auto fallback = [&](size_t ix) {
+        try {
+            sink(ix, readFile(fnames[ix]));
+        } catch (...) {
+            errors[ix] = std::current_exception();
+        }
+    };
+
+    // io_uring failed: the remaining files are read with readFile()
+    bool isFailed = false;
+    for (size_t ixBatch = 0; ixBatch < nFiles; ixBatch += batchSize) {
+        const size_t n = std::min(batchSize, nFiles - ixBatch);
+        if (isFailed) {
+            for (size_t ix = 0; ix < n; ++ix)
+                fallback(ixBatch + ix);
+            continue;
+        }
+        vector<int> fds(n, -1);
+        vector<string> contents(n);
+        vector<bool> isDone(n, false);
+
+        // submits and waits for nPending completions, passing each to handle. On failure, first collects all requests already submitted
+        // (they still use fds and buffers of the batch), then returns false
+        auto complete = [&](size_t nPending, const std::function<void(const io_uring_cqe&)>& handle) {
+            io_uring_cqe cqe;
+            while (nPending > 0) {
+                if (!q.submitAndWait()) break;
+                while (q.pop(cqe)) {
+                    --nPending;
+                    handle(cqe);
+                }
+            }
+            if (nPending == 0) return true;
+            while (q.inFlight() > 0) {
+                if (!q.wait()) {
+                    // the kernel may still write into the buffers: they can't be freed
+                    new vector<string>(std::move(contents));
+                    break;
+                }
+                while (q.pop(cqe))
+                    handle(cqe);
+            }
+            return false;
+        };
+        // closes remaining fds, delivers the files of the batch not yet delivered with readFile()
+        auto fail = [&]() {
+            isFailed = true;
+            for (size_t ix = 0; ix < n; ++ix) {
+                if (fds[ix] >= 0) ::close(fds[ix]);
+                fds[ix] = -1;
+                if (!isDone[ix]) fallback(ixBatch + ix);
+            }
+        };
+
+        // === submit all opens of the batch at once ===
+        for (size_t ix = 0; ix < n; ++ix) {
+            io_uring_sqe sqe;
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = reinterpret_cast<uintptr_t>(fnames[ixBatch + ix].c_str());
+            sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            sqe.user_data = ix;
+            q.push(sqe);
+        }
+        if (!complete(n, [&](const io_uring_cqe& cqe) { fds[cqe.user_data] = cqe.res; /* negative errno on failure */ })) {
+            fail();
+            continue;
+        }
+
+        // === submit all reads of the batch at once ===
+        size_t nPending = 0;
+        for (size_t ix = 0; ix < n; ++ix) {
+            struct stat st;
+            if ((fds[ix] < 0) || (::fstat(fds[ix], &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size > 0x7FFFFFFF)) {
+                // unsupported opcode on old kernels, errors, special files: let plain I/O handle (and report) it
+                if (fds[ix] >= 0) ::close(fds[ix]);
+                fds[ix] = -1;
+                isDone[ix] = true;
+                fallback(ixBatch + ix);
+                continue;
+            }
+            contents[ix].resize(st.st_size);
+            if (st.st_size == 0) {
+                ::close(fds[ix]);
+                fds[ix] = -1;
+                isDone[ix] = true;
+                deliver(ixBatch + ix, std::move(contents[ix]));
+                continue;
+            }
+            io_uring_sqe sqe;
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fds[ix];
+            sqe.addr = reinterpret_cast<uintptr_t>(contents[ix].data());
+            sqe.len = st.st_size;
+            sqe.off = 0;
+            sqe.user_data = ix;
+            q.push(sqe);
+            ++nPending;
+        }
+
+        // === hand over contents in order of completion ===
+        const bool isComplete = complete(nPending, [&](const io_uring_cqe& cqe) {
+            const size_t ix = cqe.user_data;
+            ::close(fds[ix]);
+            fds[ix] = -1;
+            isDone[ix] = true;
+            if ((cqe.res < 0) || ((size_t)cqe.res != contents[ix].size())) {
+                // failed or short read (e.g. file changed size)
+                fallback(ixBatch + ix);
+                return;
+            }
+            deliver(ixBatch + ix, std::move(contents[ix]));
+        });
+        if (!isComplete) fail();
+    }
+
+    for (const exception_ptr& e : errors)
+        if (e) std::rethrow_exception(e);
+    return true;
+#else
+    (void)fnames;
+    (void)sink;
+    return false;
+#endif
+}
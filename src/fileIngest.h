@@ -0,0 +1,26 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// reads many files with few syscalls: opens and reads are submitted to io_uring in batches (Linux), with fallback to plain reads
+class fileIngest {
+   public:
+    // receives the contents of file fnames[ix]. Called from the readAll() thread, in order of completion
+    typedef std::function<void(size_t ix, std::string&& contents)> sink_t;
+    MHPP("begin fileIngest") // === autogenerated code. Do not edit ===
+    public:
+    	// reads all files, handing each to sink as it completes. Throws (after all other files were delivered) if a file cannot be read
+    	static void readAll(const std::vector<std::string>& fnames, const sink_t& sink);
+    	// reads one file with plain stream I/O
+    	static std::string readFile(const std::string& fname);
+    private:
+    	// reads files via io_uring. Returns false if io_uring is unavailable (nothing delivered). Files that fail on io_uring are read with readFile(),
+    	// as are all remaining files once io_uring itself fails (after its requests in flight completed)
+    	static bool readAllUring(const std::vector<std::string>& fnames, const sink_t& sink);
+    MHPP("end fileIngest")
+};
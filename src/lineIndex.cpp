@@ -0,0 +1,63 @@
+#include "lineIndex.h"
+
+#include <algorithm>
+#include <cstring>  // memchr
+#include <stdexcept>
+#include <string>
+using std::string, std::runtime_error, std::to_string;
+
+MHPP("public")
+// indexes [begin, end). Skips to the next newline with memchr, which common C libraries vectorize: much faster than a per-character loop
+lineIndex::lineIndex(const char* begin, const char* end) : lineStarts(1, 0), size(end - begin) {
+    const char* p = begin;
+    while (p != end) {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (p == nullptr) break;
+        ++p;
+        lineStarts.push_back(p - begin);
+    }
+}
+
+MHPP("public")
+// line and character position (0-based) of offset into the text. A newline belongs to the line it ends
+void lineIndex::position(size_t offset, size_t& line, size_t& character) const {
+    if (offset > size) throw runtime_error("lineIndex: offset " + to_string(offset) + " is beyond the end of text");
+    // === last line starting at or before offset ===
+    line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin() - 1;
+    character = offset - lineStarts[line];
+}
+
+MHPP("public")
+// line-/character position of offsetBegin..offsetEnd, as regionInSource() of the range types
+void lineIndex::regionInSource(size_t offsetBegin, size_t offsetEnd, bool base1, size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const {
+    const size_t offset = base1 ? 1 : 0;
+    position(offsetBegin, lineBegin, charBegin);
+    position(offsetEnd, lineEnd, charEnd);
+    lineBegin += offset;
+    charBegin += offset;
+    lineEnd += offset;
+    charEnd += offset;
+}
+
+MHPP("public static")
+// compares results with a linear scan. Throws on mismatch
+void lineIndex::testcases() {
+    for (const string text : {"", "\n", "a", "ab\ncd\n\nefg", "\r\nx\r\n"}) {
+        const lineIndex li(text.data(), text.data() + text.size());
+        size_t lcount = 0;
+        size_t ccount = 0;
+        for (size_t ix = 0; ix <= text.size(); ++ix) {
+            size_t line;
+            size_t character;
+            li.position(ix, line, character);
+            if ((line != lcount) || (character != ccount)) throw runtime_error("lineIndex testcase failed: offset " + to_string(ix) + " of '" + text + "'");
+            if (ix == text.size()) break;
+            if (text[ix] == '\n') {
+                ++lcount;
+                ccount = 0;
+            } else {
+                ++ccount;
+            }
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// start offsets of all lines in a text, for line-/character position lookup by binary search (see myRegexRange, regionizedText, stringRegion::regionInSource).
+// Built once per text, then each lookup is O(log(number of lines)) instead of a scan from the start of the text
+class lineIndex {
+    MHPP("begin lineIndex") // === autogenerated code. Do not edit ===
+    public:
+    	// indexes [begin, end). Skips to the next newline with memchr, which common C libraries vectorize: much faster than a per-character loop
+    	lineIndex(const char* begin, const char* end);
+    	// line and character position (0-based) of offset into the text. A newline belongs to the line it ends
+    	void position(size_t offset, size_t& line, size_t& character) const;
+    	// line-/character position of offsetBegin..offsetEnd, as regionInSource() of the range types
+    	void regionInSource(size_t offsetBegin, size_t offsetEnd, bool base1, size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const;
+    	// compares results with a linear scan. Throws on mismatch
+    	static void testcases();
+    MHPP("end lineIndex")
+   private:
+    // offset of the first character of each line (lineStarts[0] is 0)
+    std::vector<size_t> lineStarts;
+    // length of the indexed text
+    size_t size;
+};
@@ -3,32 +3,141 @@
 #include <map>
 #include <regex>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
 #include "codeGen.h"
+#include "dirScan.h"
+#include "lineIndex.h"
 #include "myAppRegex.h"
+#include "myRegexAst.h"
+#include "myRegexNfa.h"
 #include "myRegexRange.h"
+#include "regexRegistry.h"
+#include "regionizedText.h"
+#include "sectionScanner.h"
+#include "serverMode.h"
+#include "watchMode.h"
 //
 using std::string, std::runtime_error, std::vector, std::set, std::map, std::cout;
 
+// regular (non-resident) run on one group of files. Returns depfile rules
+static string processGroup(const vector<string>& filenames, bool annotate, bool clean, codeGen::inputMode_e inputMode, const string& cacheDir, workerPool& pool) {
+    codeGen cg(annotate, inputMode);
+    if (cacheDir.size() > 0)
+        cg.useCache(cacheDir);
+
+    // === parse all files for declarations ===
+    cg.pass1(filenames, clean, pool);
+
+    // === fill in declarations ===
+    cg.pass2(filenames, clean, pool);
+
+    // === sanity check: all declarations referenced? ===
+    if (!clean)
+        cg.checkAllClassesDone();
+
+    // === write output ===
+    cg.pass3(filenames, pool);
+    return cg.depfileRules();
+}
+
+// --dumpregex: the pattern as composed, and as optimized (same captures) for the matching engine
+static string dumpRegex(const string& name) {
+    const map<string, myRegexBase> patterns = {
+        {"classfun", myAppRegex::MHPP_classfun()},
+        {"classvar", myAppRegex::MHPP_classvar()},
+        {"begin", myAppRegex::MHPP_begin()},
+        {"scan", myRegexBase(myAppRegexCt::scanDecl)}};
+    auto it = patterns.find(name);
+    if (it == patterns.end()) throw runtime_error("--dumpregex: unknown pattern '" + name + "'");
+    const myRegexBase optimized = it->second.optimized(it->second.getNames());
+    const myRegexAst ast = optimized.getAst();
+    string leads;
+    for (const string& l : ast.leadingLiterals())
+        leads += " '" + l + "'";
+    return "expression: " + it->second.getExpr() + "\n" +
+           "optimized: " + optimized.getExpr() + "\n" +
+           "required literal: '" + ast.requiredLiteral() + "'\n" +
+           "leading literals:" + leads + "\n" +
+           "tree:\n" + ast.dump();
+}
+
+// reads a --manifest file: one group of whitespace-separated filenames per line, '#' starts a comment
+static vector<vector<string>> readManifest(const string& manifest) {
+    const string text = fileIngest::readFile(manifest);
+    vector<vector<string>> groups;
+    size_t lineNum = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t eol = text.find('\n', pos);
+        string line = text.substr(pos, eol == string::npos ? string::npos : eol - pos);
+        pos = (eol == string::npos) ? text.size() : eol + 1;
+        ++lineNum;
+        line = line.substr(0, line.find('#'));
+
+        vector<string> group;
+        set<string> uniqueFilenames;
+        std::istringstream is(line);
+        string f;
+        while (is >> f) {
+            if (!uniqueFilenames.insert(f).second)
+                throw runtime_error(manifest + " line " + std::to_string(lineNum) + ": duplicate filename: '" + f + "'");
+            group.push_back(f);
+        }
+        if (group.size() > 0)
+            groups.push_back(group);
+    }
+    return groups;
+}
+
 int main(int argc, const char** argv) {
     std::map<std::string, myRegexRange> captures;
-    myRegexRange testexpr("std::vector<int>", "hardcoded");
+    const myRegexRange::root_t testexpr = myRegexRange::own("std::vector<int>", "hardcoded");
     
-    assert(testexpr.match(myAppRegex::CppTemplatedType, captures));
+    assert(testexpr->match(myAppRegex::CppTemplatedType, captures));
 
     // === copy command line args as filenames ===
     vector<string> filenames;
     set<string> uniqueFilenames;
     bool annotate = false;
     bool clean = false;
+    bool mmapInput = false;
+    bool batchRead = false;
+    size_t nThreads = 1;
+    string serverSocket;
+    string clientSocket;
+    string stopSocket;
+    bool watch = false;
+    bool timing = false;
+    string cacheDir;
+    string depfile;
+    string manifest;
+    vector<string> recurseDirs;
+    vector<string> includes;
+    vector<string> excludes;
 
     if (argc <= 1) {
         cout << "usage: " << argv[0] <<  //
             " myfile1.cpp myfile2.h ...\n"
             "-annotate: add comment with declaration file and line\n"
-            "-clean: remove all generated code\n";
+            "-clean: remove all generated code\n"
+            "-j N: process files using N threads\n"
+            "-mmap: map input files into memory instead of reading them\n"
+            "-batchread: read input files in batches (io_uring where available)\n"
+            "-nfa: use the linear-time matching engine instead of std::regex\n"
+            "-timing: report time spent compiling regexes\n"
+            "--dumpregex NAME: print expression tree and optimized expression of pattern NAME (classfun, classvar, begin, scan)\n"
+            "-r DIR: process all files below DIR that contain MHPP markers\n"
+            "--include GLOB, --exclude GLOB: filter files found by -r (filename or path relative to DIR, may be repeated)\n"
+            "--cache DIR: reuse scan results of unchanged files from earlier runs, stored in DIR\n"
+            "--manifest FILE: process groups of files listed in FILE (one group per line) independently, in one process\n"
+            "--depfile FILE: write make/ninja dependencies of files with MHPP(\"begin ...\") sections on their source files\n"
+            "--server SOCKET: stay resident, regenerate on request from --client\n"
+            "--client SOCKET: tell the server that the given files changed, wait for regeneration\n"
+            "--stop SOCKET: shut down the server\n"
+            "--watch: stay resident, regenerate when files change (watches the files' directories)\n";
         exit(0);
     }
 
@@ -38,6 +147,61 @@ int main(int argc, const char** argv) {
             annotate = true;
         else if (f == "-clean")
             clean = true;
+        else if (f == "-mmap")
+            mmapInput = true;
+        else if (f == "-batchread")
+            batchRead = true;
+        else if (f == "-nfa")
+            myRegexBase::setEngine(myRegexBase::ENGINE_NFA);
+        else if (f == "-timing")
+            timing = true;
+        else if (f == "--selftest") {
+            myRegexNfa::testcases();
+            myRegexRange::testcases();
+            myRegexAst::testcases();
+            sectionScanner::testcases();
+            regionized::testcases();
+            regionizedText::testcases();
+            lineIndex::testcases();
+            cout << "selftest passed\n";
+            return 0;
+        }
+        else if (f == "--watch")
+            watch = true;
+        else if ((f == "-r") || (f == "--include") || (f == "--exclude")) {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires an argument");
+            vector<string>& dest = (f == "-r") ? recurseDirs : (f == "--include") ? includes
+                                                                                   : excludes;
+            dest.push_back(argv[ix]);
+        } else if (f == "--cache") {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires a directory");
+            cacheDir = argv[ix];
+        } else if (f == "--dumpregex") {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires a pattern name");
+            cout << dumpRegex(argv[ix]);
+            return 0;
+        } else if (f == "--manifest") {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires a filename");
+            manifest = argv[ix];
+        } else if (f == "--depfile") {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires a filename");
+            depfile = argv[ix];
+        } else if ((f == "--server") || (f == "--client") || (f == "--stop")) {
+            if (++ix == (size_t)argc) throw runtime_error(f + " requires a socket path");
+            string& socketPath = (f == "--server") ? serverSocket : (f == "--client") ? clientSocket
+                                                                                       : stopSocket;
+            socketPath = argv[ix];
+        } else if (f.rfind("-j", 0) == 0) {
+            // -j N or -jN
+            string n = f.substr(2);
+            if (n.size() == 0) {
+                if (++ix == (size_t)argc) throw runtime_error("-j requires a number of threads");
+                n = argv[ix];
+            }
+            if ((n.find_first_not_of("0123456789") != string::npos) || (std::stoul(n) == 0))
+                throw runtime_error("-j: invalid number of threads '" + n + "'");
+            nThreads = std::stoul(n);
+        }
         else {
             filenames.push_back(f);
             if (!uniqueFilenames.insert(f).second)
@@ -46,24 +210,59 @@ int main(int argc, const char** argv) {
     }
 
     if (annotate && clean) throw runtime_error("-annotate and -clean are mutually exclusive");
+    if (mmapInput && batchRead) throw runtime_error("-mmap and -batchread are mutually exclusive");
+    const codeGen::inputMode_e inputMode = mmapInput ? codeGen::INPUT_MMAP : batchRead ? codeGen::INPUT_BATCHREAD
+                                                                                   : codeGen::INPUT_READ;
 
-    codeGen cg(annotate);
-
-    // === parse all files for declarations ===
-    for (const string& filename : filenames)
-        cg.pass1(filename, clean);
+    // === client side of resident mode ===
+    if (stopSocket.size() > 0)
+        return serverMode::requestStop(stopSocket) ? 0 : 1;
+    if (clientSocket.size() > 0)
+        return serverMode::request(clientSocket, filenames) ? 0 : 1;
+    if ((serverSocket.size() > 0) && clean) throw runtime_error("--server and -clean are mutually exclusive");
+    if (watch && clean) throw runtime_error("--watch and -clean are mutually exclusive");
+    if (watch && (serverSocket.size() > 0)) throw runtime_error("--watch and --server are mutually exclusive");
+    if ((depfile.size() > 0) && (watch || (serverSocket.size() > 0))) throw runtime_error("--depfile is not supported in resident mode");
+    if ((manifest.size() > 0) && (watch || (serverSocket.size() > 0))) throw runtime_error("--manifest is not supported in resident mode");
+    // (a mapping shows later writes to the file: changes would go undetected, a truncated file raises SIGBUS)
+    if ((inputMode == codeGen::INPUT_MMAP) && (watch || (serverSocket.size() > 0))) throw runtime_error("-mmap is not supported in resident mode");
+    if ((manifest.size() > 0) && ((filenames.size() > 0) || (recurseDirs.size() > 0))) throw runtime_error("--manifest and filenames on the command line are mutually exclusive");
 
-    // === fill in declarations ===
-    for (const string& filename : filenames)
-        cg.pass2(filename, clean);
+    workerPool pool(nThreads);
 
-    // === sanity check: all declarations referenced? ===
-    if (!clean)
-        cg.checkAllClassesDone();
+    // === add files from -r (files given explicitly as well are not duplicated) ===
+    for (const string& dir : recurseDirs)
+        for (const string& f : dirScan::collect(dir, includes, excludes, pool))
+            if (uniqueFilenames.insert(f).second)
+                filenames.push_back(f);
 
-    // === write output ===
-    for (const string& filename : filenames)
-        cg.pass3(filename);
+    // === regular run ===
+    if (!watch && (serverSocket.size() == 0)) {
+        string depRules;
+        if (manifest.size() > 0) {
+            // groups are independent projects (own classes, own completeness check). They share worker threads and compiled regexes
+            for (const vector<string>& group : readManifest(manifest))
+                depRules += processGroup(group, annotate, clean, inputMode, cacheDir, pool);
+        } else {
+            depRules = processGroup(filenames, annotate, clean, inputMode, cacheDir, pool);
+        }
+        if (depfile.size() > 0)
+            codeGen::writeFileAtomic(depfile, depRules);
+        if (timing)
+            cout << regexRegistry::report() << "\n";
+        return 0;
+    }
 
+    // === resident mode ===
+    codeGen cg(annotate, inputMode);
+    if (cacheDir.size() > 0)
+        cg.useCache(cacheDir);
+    cg.pass1(filenames, clean, pool);
+    if (timing)
+        cout << regexRegistry::report() << "\n";
+    if (serverSocket.size() > 0)
+        serverMode::serve(serverSocket, cg, filenames, pool);
+    else
+        watchMode::watch(cg, filenames, pool);
     return 0;
 }
\ No newline at end of file
@@ -1,148 +1,82 @@
 #include "myAppRegex.h"
 
 #include <iostream>
+
+// capture indices resolve at compile time
+static_assert(myAppRegexCt::MHPP_begin.captureIndex("classname1") == 2);
+
 MHPP("public")
 myAppRegex::myAppRegex(const myRegexBase& arg) : myRegexBase(arg) {}
 
 MHPP("public static")
-myAppRegex myAppRegex::comment() {
-    return capture("leadingComment", oneOrMore(CComment | CppComment)) + wsOpt;
-}
+myAppRegex myAppRegex::comment() { return myAppRegexCt::comment; }
 
 MHPP("public static")
-myAppRegex myAppRegex::MHPP_classfun() {
-    return txt("MHPP(\"") +
-           // public or private or protected (all start with "p")
-           capture("fun_MHPP_keyword", txt("p") + zeroOrMore_lazy(rx("."))) + txt("\")") + wsOpt +
-           capture("fun_comment", zeroOrMore(CComment | CppComment)) + wsOpt +
-           // return type (optional, free form for templates, may include constexpr, const separated by whitespace)
-           zeroOrOne(
-               capture("fun_returntype", CppTemplatedType) + wsSep) +
-           // method name
-           capture("fun_classmethodname", CppClassname + doubleColon + makeGrp(CppMethodname | CppOperator)) +
-
-           // arguments list (may not contain a round bracket)
-           capture("fun_arglist", openRoundBracket + rx("[^\\)\\{]*") + closingRoundBracket) + wsOpt +
-           // constructor initializers
-           // "constexpr", "const" qualifiers after arg list
-           capture("fun_postArg", rx("[^\\{\\;]*")) + wsOpt +
-           txt("{");
-}
+myAppRegex myAppRegex::MHPP_classfun() { return myAppRegexCt::MHPP_classfun; }
 
 MHPP("public static")
-myAppRegex myAppRegex::MHPP_classvar() {
-    return txt("MHPP(\"") +
-           // public or private or protected (all start with "p")
-           capture("var_MHPP_keyword", txt("p") + zeroOrMore_lazy(rx("[a-zA-Z0-9_\\s]"))) + txt("\")") + wsOpt +
-           capture("var_comment", zeroOrMore(CComment | CppComment)) + wsOpt +
-           // return type (optional, free form for templates, may include constexpr, const separated by whitespace)
-           capture("var_returntype", rx("[_a-zA-Z0-9<>,:\\s]*?")) +
-
-           // name
-           capture("var_classvarname",
-                   rx("["
-                      "_"
-                      ":"
-                      "a-z"
-                      "A-Z"
-                      "0-9"
-                      "]+")) +
-           wsOpt + zeroOrOne(rx("="
-                                ".*")) +
-           txt(";");
-}
+myAppRegex myAppRegex::MHPP_classvar() { return myAppRegexCt::MHPP_classvar; }
 
 MHPP("public static")
-myAppRegex myAppRegex::MHPP_begin() {
-    myAppRegex classname = Cidentifier + zeroOrMore(doubleColon + Cidentifier);
-
-    myAppRegex r =
-        // indent of MHPP(...)
-        capture("indent", rx("[ \\t]*")) +
-
-        // MHPP ("begin myClass::myMethod")
-        txt("MHPP(\"begin ") +
-        capture("classname1", classname) +
-        txt("\")") +
-
-        // existing definitions (to be replaced)
-        capture("body", rx("[\\s\\S]*?")) +
-
-        // MHPP ("end myClass::myMethod")
-        txt("MHPP(\"end ") +
-        capture("classname2", classname) +
-        txt("\")");
-
-    return r;
-}
+myAppRegex myAppRegex::MHPP_begin() { return myAppRegexCt::MHPP_begin; }
 
 MHPP("public static")
 // splits myOuterClass::myInnerClass::myMethod into classname=myOuterClass::myInnerClass and methodname=myMethod
-myAppRegex myAppRegex::classMethodname() {
-    myAppRegex r = capture("classname",
-                           Cidentifier +
-                               zeroOrMore(doubleColon + Cidentifier)) +
-                   doubleColon +
-                   capture("methodname",
-                           makeGrp(zeroOrOne(txt("~")) +
-                                   Cidentifier) |
-                               CppOperator);
-    return r;
-}
+myAppRegex myAppRegex::classMethodname() { return myAppRegexCt::classMethodname; }
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppOperator = myAppRegex::rx("operator\\s*[\\+\\-\\*\\/\\(\\)<>|&~]+");
+myAppRegex myAppRegex::CppOperator = myAppRegexCt::CppOperator;
 
 MHPP("protected static")
-myAppRegex myAppRegex::wsSep = myAppRegex::rx("\\s+");
+myAppRegex myAppRegex::wsSep = myAppRegexCt::wsSep;
 
 MHPP("protected static")
-myAppRegex myAppRegex::openRoundBracket = myAppRegex::txt("(");
+myAppRegex myAppRegex::openRoundBracket = myAppRegexCt::openRoundBracket;
 
 MHPP("protected static")
-myAppRegex myAppRegex::closingRoundBracket = myAppRegex::txt(")");
+myAppRegex myAppRegex::closingRoundBracket = myAppRegexCt::closingRoundBracket;
 
 MHPP("protected static")
-myAppRegex myAppRegex::wsOpt = myAppRegex::rx("\\s*");
+myAppRegex myAppRegex::wsOpt = myAppRegexCt::wsOpt;
 
 MHPP("protected static")
-myAppRegex myAppRegex::doubleQuote = myAppRegex::txt("\"");
+myAppRegex myAppRegex::doubleQuote = myAppRegexCt::doubleQuote;
 
 MHPP("protected static")
-myAppRegex myAppRegex::Cidentifier = myAppRegex::rx("[_a-zA-Z][_a-zA-Z0-9]*");
+myAppRegex myAppRegex::Cidentifier = myAppRegexCt::Cidentifier;
 
 MHPP("protected static")
-myAppRegex myAppRegex::eol = myAppRegex::rx("\\r?\\n");
+myAppRegex myAppRegex::eol = myAppRegexCt::eol;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CComment = myAppRegex::rx("//.*") + eol;
+myAppRegex myAppRegex::CComment = myAppRegexCt::CComment;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppComment = myAppRegex::rx("/\\*.*?\\*/") + eol;
+myAppRegex myAppRegex::CppComment = myAppRegexCt::CppComment;
 
 MHPP("protected static")
-myAppRegex myAppRegex::doubleColon = txt("::");
+myAppRegex myAppRegex::doubleColon = myAppRegexCt::doubleColon;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppIdentifierFirstChar = myAppRegex::rx("[_a-zA-Z]");
+myAppRegex myAppRegex::CppIdentifierFirstChar = myAppRegexCt::CppIdentifierFirstChar;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppTemplatedTypeFirstChar = myAppRegex::rx("[:_a-zA-Z]");
+myAppRegex myAppRegex::CppTemplatedTypeFirstChar = myAppRegexCt::CppTemplatedTypeFirstChar;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppTemplatedTypeBodyChar = myAppRegex::rx("[_a-zA-Z0-9<>,\\s:]");
+myAppRegex myAppRegex::CppTemplatedTypeBodyChar = myAppRegexCt::CppTemplatedTypeBodyChar;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppTemplatedTypeLastChar = myAppRegex::rx("[_a-zA-Z0-9>]");
+myAppRegex myAppRegex::CppTemplatedTypeLastChar = myAppRegexCt::CppTemplatedTypeLastChar;
 
 MHPP("public static")
-myAppRegex myAppRegex::CppTemplatedType = myAppRegex::rx("[a-zA-Z0-9_<>,\\s:\\*&]+");
+myAppRegex myAppRegex::CppTemplatedType = myAppRegexCt::CppTemplatedType;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppClassname = myAppRegex::rx("[_a-zA-Z0-9:]+");
+myAppRegex myAppRegex::CppClassname = myAppRegexCt::CppClassname;
 
 MHPP("protected static")
-myAppRegex myAppRegex::CppMethodname = myAppRegex::makeGrp(myAppRegex::zeroOrMore(myAppRegex::txt("~")) + Cidentifier);
+myAppRegex myAppRegex::CppMethodname = myAppRegexCt::CppMethodname;
 
 MHPP("protected static")
-myAppRegex myAppRegex::any = wsOpt + rx(".*");  // regex "." does not include newline
\ No newline at end of file
+myAppRegex myAppRegex::any = myAppRegexCt::any;  // regex "." does not include newline
\ No newline at end of file
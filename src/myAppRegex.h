@@ -1,5 +1,6 @@
 #pragma once
 #include "myRegexBase.h"
+#include "myRegexCt.h"
 
 // rexex wrapper with application-specific "macros" e.g. wsSep for "\s+" or wsOpt for "\s*"
 class myAppRegex : public myRegexBase {
@@ -34,5 +35,83 @@ class myAppRegex : public myRegexBase {
     	static myAppRegex CppMethodname;
     	static myAppRegex any;
     MHPP("end myAppRegex")
+   public:
+    template <size_t CAP>
+    myAppRegex(const myRegexCt<CAP>& ct) : myRegexBase(ct) {}
+};
+
+// the patterns of myAppRegex, composed at compile time
+class myAppRegexCt : public myRegexCtBase {
+   public:
+    static constexpr auto CppOperator = rx("operator\\s*[\\+\\-\\*\\/\\(\\)<>|&~]+");
+    static constexpr auto wsSep = rx("\\s+");
+    static constexpr auto openRoundBracket = txt("(");
+    static constexpr auto closingRoundBracket = txt(")");
+    static constexpr auto wsOpt = rx("\\s*");
+    static constexpr auto doubleQuote = txt("\"");
+    static constexpr auto Cidentifier = rx("[_a-zA-Z][_a-zA-Z0-9]*");
+    static constexpr auto eol = rx("\\r?\\n");
+    static constexpr auto CComment = rx("//.*") + eol;
+    static constexpr auto CppComment = rx("/\\*.*?\\*/") + eol;
+    static constexpr auto doubleColon = txt("::");
+    static constexpr auto CppIdentifierFirstChar = rx("[_a-zA-Z]");
+    static constexpr auto CppTemplatedTypeFirstChar = rx("[:_a-zA-Z]");
+    static constexpr auto CppTemplatedTypeBodyChar = rx("[_a-zA-Z0-9<>,\\s:]");
+    static constexpr auto CppTemplatedTypeLastChar = rx("[_a-zA-Z0-9>]");
+    static constexpr auto CppTemplatedType = rx("[a-zA-Z0-9_<>,\\s:\\*&]+");
+    static constexpr auto CppClassname = rx("[_a-zA-Z0-9:]+");
+    static constexpr auto CppMethodname = makeGrp(zeroOrMore(txt("~")) + Cidentifier);
+    static constexpr auto any = wsOpt + rx(".*");  // regex "." does not include newline
+
+    static constexpr auto comment = capture("leadingComment", oneOrMore(CComment | CppComment)) + wsOpt;
+
+    static constexpr auto MHPP_classfun =
+        txt("MHPP(\"") +
+        // public or private or protected (all start with "p")
+        capture("fun_MHPP_keyword", txt("p") + zeroOrMore_lazy(rx("."))) + txt("\")") + wsOpt +
+        capture("fun_comment", zeroOrMore(CComment | CppComment)) + wsOpt +
+        // return type (optional, free form for templates, may include constexpr, const separated by whitespace)
+        zeroOrOne(
+            capture("fun_returntype", CppTemplatedType) + wsSep) +
+        // method name
+        capture("fun_classmethodname", CppClassname + doubleColon + makeGrp(CppMethodname | CppOperator)) +
+        // arguments list (may not contain a round bracket)
+        capture("fun_arglist", openRoundBracket + rx("[^\\)\\{]*") + closingRoundBracket) + wsOpt +
+        // constructor initializers
+        // "constexpr", "const" qualifiers after arg list
+        capture("fun_postArg", rx("[^\\{\\;]*")) + wsOpt +
+        txt("{");
+
+    static constexpr auto MHPP_classvar =
+        txt("MHPP(\"") +
+        // public or private or protected (all start with "p")
+        capture("var_MHPP_keyword", txt("p") + zeroOrMore_lazy(rx("[a-zA-Z0-9_\\s]"))) + txt("\")") + wsOpt +
+        capture("var_comment", zeroOrMore(CComment | CppComment)) + wsOpt +
+        // return type (optional, free form for templates, may include constexpr, const separated by whitespace)
+        capture("var_returntype", rx("[_a-zA-Z0-9<>,:\\s]*?")) +
+        // name
+        capture("var_classvarname", rx("[_:a-zA-Z0-9]+")) +
+        wsOpt + zeroOrOne(rx("=.*")) +
+        txt(";");
+
+    static constexpr auto MHPP_beginClassname = Cidentifier + zeroOrMore(doubleColon + Cidentifier);
+    static constexpr auto MHPP_begin =
+        // indent of MHPP(...)
+        capture("indent", rx("[ \\t]*")) +
+        // MHPP ("begin myClass::myMethod")
+        txt("MHPP(\"begin ") + capture("classname1", MHPP_beginClassname) + txt("\")") +
+        // existing definitions (to be replaced)
+        capture("body", rx("[\\s\\S]*?")) +
+        // MHPP ("end myClass::myMethod")
+        txt("MHPP(\"end ") + capture("classname2", MHPP_beginClassname) + txt("\")");
+
+    // splits myOuterClass::myInnerClass::myMethod into classname=myOuterClass::myInnerClass and methodname=myMethod
+    static constexpr auto classMethodname =
+        capture("classname", Cidentifier + zeroOrMore(doubleColon + Cidentifier)) +
+        doubleColon +
+        capture("methodname", makeGrp(zeroOrOne(txt("~")) + Cidentifier) | CppOperator);
+
+    // declarations and comments, as searched by codeGen::scan()
+    static constexpr auto scanDecl = comment.makeGrp() | MHPP_classfun.makeGrp() | MHPP_classvar.makeGrp();
 };
 
@@ -0,0 +1,576 @@
+#include "myRegexAst.h"
+
+#include <algorithm>
+#include <cctype>
+#include <regex>
+#include <stdexcept>
+#include <utility>
+using std::string, std::vector, std::runtime_error, std::to_string;
+
+// maximum number of leadingLiterals() (combinations of alternatives multiply)
+static const size_t MAXLEADS = 64;
+
+[[noreturn]] static void failAt(const string& expr, const string& what, size_t pos) {
+    throw runtime_error("regex '" + expr + "': " + what + " at position " + to_string(pos));
+}
+
+// literal text at the start of n (only direct: not inside groups, which may be captures)
+static string leadingText(const myRegexAst::node_t& n) {
+    if (n.type == myRegexAst::NODE_LITERAL) return n.text;
+    if ((n.type == myRegexAst::NODE_CONCAT) && (n.children.size() > 0) && (n.children[0].type == myRegexAst::NODE_LITERAL)) return n.children[0].text;
+    return "";
+}
+
+// removes the first nChars of leadingText(n)
+static void stripLeadingText(myRegexAst::node_t& n, size_t nChars) {
+    myRegexAst::node_t& lit = (n.type == myRegexAst::NODE_LITERAL) ? n : n.children[0];
+    lit.text.erase(0, nChars);
+    if (lit.text.size() > 0) return;
+    if (&lit == &n)
+        n = myRegexAst::node_t{myRegexAst::NODE_CONCAT, "", {}};  // empty alternative
+    else
+        n.children.erase(n.children.begin());
+}
+
+// ==========================
+// === myRegexAst public
+// ==========================
+
+MHPP("public")
+// parses expr with capture names in order of appearance (as myRegexBase). Throws on unsupported syntax
+myRegexAst::myRegexAst(const std::string& expr, const std::vector<std::string>& captureNames) : expr(expr), names(captureNames), nCaptures(0), root() {
+    size_t pos = 0;
+    root = parseAlt(pos);
+    if (pos != expr.size()) failAt(expr, "unbalanced ')'", pos);
+    if (nCaptures != names.size()) throw runtime_error("regex '" + expr + "': " + to_string(nCaptures) + " captures but " + to_string(names.size()) + " capture names");
+    simplify(root);
+    this->expr.clear();
+    names.clear();
+}
+
+MHPP("public")
+// regex expression of the (optimized) tree
+std::string myRegexAst::str() const { return str(root); }
+
+MHPP("public")
+// capture names in order of appearance, which is the capture numbering
+std::vector<std::string> myRegexAst::getNames() const {
+    vector<string> r;
+    collectNames(root, r);
+    return r;
+}
+
+MHPP("public")
+// one line per node, indented by depth
+std::string myRegexAst::dump() const {
+    string r;
+    dump(root, 0, r);
+    return r;
+}
+
+MHPP("public")
+// turns captures not listed in keep into (?: ... ) groups. Renumbers the remaining captures
+void myRegexAst::removeCaptures(const std::vector<std::string>& keep) {
+    removeCaptures(root, keep);
+    simplify(root);
+}
+
+MHPP("public")
+// factors a common literal prefix out of adjacent alternatives e.g. ab|ac|d => a(?:b|c)|d. Same matches, captures unchanged.
+// Only literal prefixes are factored: a prefix that can match in more than one way would change which alternative wins
+void myRegexAst::factorPrefixes() {
+    factorPrefixes(root);
+    simplify(root);
+}
+
+MHPP("public")
+// longest text that every match contains (empty if none)
+std::string myRegexAst::requiredLiteral() const {
+    bool isExact;
+    string prefix;
+    string suffix;
+    string best;
+    literalInfo(root, isExact, prefix, suffix, best);
+    return best;
+}
+
+MHPP("public")
+// texts one of which every match starts with (empty if any match may start differently). Usable as anchors for myRegexRange::forEachMatch
+std::vector<std::string> myRegexAst::leadingLiterals() const {
+    vector<string> leads;
+    if (!leadingLiterals(root, leads)) return vector<string>();
+    // === a text starting with another one is redundant ===
+    std::sort(leads.begin(), leads.end());
+    vector<string> r;
+    for (const string& l : leads)
+        if ((r.size() == 0) || (l.compare(0, r.back().size(), r.back()) != 0))
+            r.push_back(l);
+    return r;
+}
+
+MHPP("public static")
+// checks parser, passes and str() against std::regex. Throws on mismatch
+void myRegexAst::testcases() {
+    // === passes ===
+    auto check = [](bool ok, const string& what) {
+        if (!ok) throw runtime_error("myRegexAst testcase failed: " + what);
+    };
+    myRegexAst a("ab|ac|d", {});
+    a.factorPrefixes();
+    check(a.str() == "a(?:b|c)|d", "factorPrefixes " + a.str());
+    myRegexAst b("(?:x(?:abc|abd|ax))+(y)", {"y"});
+    b.factorPrefixes();
+    check(b.str() == "(?:xa(?:b(?:c|d)|x))+(y)", "factorPrefixes " + b.str());
+    check(b.requiredLiteral() == "xa", "requiredLiteral " + b.requiredLiteral());
+    check(b.leadingLiterals() == vector<string>({"xabc", "xabd", "xax"}), "leadingLiterals");
+    myRegexAst c("(a)(?:(b)|(c))", {"x", "y", "z"});
+    c.removeCaptures({"x", "z"});
+    check((c.str() == "(a)(?:b|(c))") && (c.getNames() == vector<string>({"x", "z"})), "removeCaptures " + c.str());
+    check(myRegexAst("(?://.*|/\\*.*?\\*/)+\\s*|MHPP\\(\"p[a-z]*\"\\)|MHPP\\(\"p", {}).leadingLiterals() == vector<string>({"/*", "//", "MHPP(\"p"}), "leadingLiterals of alternatives");
+    check(myRegexAst("a*b|c", {}).leadingLiterals().size() == 0, "leadingLiterals without literal start");
+
+    // === optimized expression matches as the original ===
+    const vector<std::pair<string, vector<string>>> cases = {
+        {"MHPP\\(\"(p.*?)\"\\)\\s*(\\w+)\\(|MHPP\\(\"(p[a-z ]*?)\"\\)\\s*(\\w+);|//.*\\r?\\n", {"MHPP(\"public\") foo(", "MHPP(\"private static\") x;", "// c\nMHPP(\"p\")y;"}},
+        {"(?:(?:ab)|(?:ab)c)*(?:x|xy)", {"ababcxy", "abx"}},
+        {"[\\]a]+?\\.(?:\\-|\\{)", {"a]].-", "x.{"}},
+    };
+    for (const auto& [expr, texts] : cases) {
+        const std::regex rxOrig(expr);
+        myRegexAst opt(expr, vector<string>(std::regex(expr).mark_count(), ""));
+        opt.factorPrefixes();
+        const std::regex rxOpt(opt.str());
+        for (const string& text : texts) {
+            std::smatch m1;
+            std::smatch m2;
+            const bool r1 = std::regex_search(text, m1, rxOrig);
+            const bool r2 = std::regex_search(text, m2, rxOpt);
+            check((r1 == r2) && (m1.size() == m2.size()), "'" + opt.str() + "' result on '" + text + "'");
+            for (size_t ix = 0; r1 && (ix < m1.size()); ++ix)
+                check((m1[ix].first == m2[ix].first) && (m1[ix].second == m2[ix].second), "'" + opt.str() + "' group " + to_string(ix) + " on '" + text + "'");
+        }
+    }
+}
+
+// ==========================
+// === myRegexAst internal
+// ==========================
+
+MHPP("private")
+// alternation at pos, up to ')' or end
+myRegexAst::node_t myRegexAst::parseAlt(size_t& pos) {
+    node_t n{NODE_ALT, "", {}};
+    n.children.push_back(parseConcat(pos));
+    while ((pos < expr.size()) && (expr[pos] == '|')) {
+        ++pos;
+        n.children.push_back(parseConcat(pos));
+    }
+    if (n.children.size() == 1) return n.children[0];
+    return n;
+}
+
+MHPP("private")
+// sequence of quantified atoms at pos, up to '|', ')' or end
+myRegexAst::node_t myRegexAst::parseConcat(size_t& pos) {
+    node_t n{NODE_CONCAT, "", {}};
+    while ((pos < expr.size()) && (expr[pos] != '|') && (expr[pos] != ')')) {
+        node_t atom = parseAtom(pos);
+
+        // === quantifier ===
+        size_t qEnd = pos;
+        if (pos < expr.size()) {
+            const char c = expr[pos];
+            if ((c == '*') || (c == '+') || (c == '?')) {
+                qEnd = pos + 1;
+            } else if (c == '{') {
+                qEnd = expr.find('}', pos);
+                if (qEnd == string::npos) failAt(expr, "missing '}'", pos);
+                ++qEnd;
+            }
+        }
+        if (qEnd != pos) {
+            if ((qEnd < expr.size()) && (expr[qEnd] == '?')) ++qEnd;  // lazy
+            if ((atom.type == NODE_ATOM) && ((atom.text == "^") || (atom.text == "$"))) failAt(expr, "quantified anchor", pos);
+            atom = node_t{NODE_REPEAT, expr.substr(pos, qEnd - pos), {atom}};
+            pos = qEnd;
+        }
+        n.children.push_back(std::move(atom));
+    }
+    return n;
+}
+
+MHPP("private")
+// group, character class, escape or single character at pos
+myRegexAst::node_t myRegexAst::parseAtom(size_t& pos) {
+    const size_t start = pos;
+    const char c = expr[pos];
+    if (c == '(') {
+        ++pos;
+        node_t n{NODE_CAPTURE, "", {}};
+        if (expr.compare(pos, 2, "?:") == 0) {
+            n.type = NODE_GROUP;
+            pos += 2;
+        } else if ((pos < expr.size()) && (expr[pos] == '?')) {
+            failAt(expr, "unsupported group type", start);
+        } else {
+            if (nCaptures == names.size()) failAt(expr, "capture without name", start);
+            n.text = names[nCaptures++];
+        }
+        n.children.push_back(parseAlt(pos));
+        if ((pos == expr.size()) || (expr[pos] != ')')) failAt(expr, "missing ')'", start);
+        ++pos;
+        return n;
+    }
+    if (c == '[') {
+        size_t p = pos + 1;
+        if ((p < expr.size()) && (expr[p] == '^')) ++p;
+        bool first = true;  // ']' as first character is a literal
+        while (true) {
+            if (p >= expr.size()) failAt(expr, "missing ']'", start);
+            if ((expr[p] == ']') && !first) break;
+            first = false;
+            p += (expr[p] == '\\') ? 2 : 1;
+        }
+        pos = p + 1;
+        return node_t{NODE_ATOM, expr.substr(start, pos - start), {}};
+    }
+    if ((c == '.') || (c == '^') || (c == '$')) {
+        ++pos;
+        return node_t{NODE_ATOM, string(1, c), {}};
+    }
+    if (c == '\\') {
+        if (pos + 1 >= expr.size()) failAt(expr, "trailing backslash", pos);
+        const char e = expr[pos + 1];
+        pos += 2;
+        switch (e) {
+            case 's':
+            case 'S':
+            case 'd':
+            case 'D':
+            case 'w':
+            case 'W':
+            case 'b':
+            case 'B':
+                return node_t{NODE_ATOM, expr.substr(start, 2), {}};
+            case 'n':
+                return node_t{NODE_LITERAL, "\n", {}};
+            case 'r':
+                return node_t{NODE_LITERAL, "\r", {}};
+            case 't':
+                return node_t{NODE_LITERAL, "\t", {}};
+            case 'f':
+                return node_t{NODE_LITERAL, "\f", {}};
+            case 'v':
+                return node_t{NODE_LITERAL, "\v", {}};
+            default:
+                if (std::isalnum((unsigned char)e)) failAt(expr, "unsupported escape", start);
+                return node_t{NODE_LITERAL, string(1, e), {}};  // escaped metacharacter
+        }
+    }
+    if ((c == '*') || (c == '+') || (c == '?') || (c == '{')) failAt(expr, "nothing to repeat", pos);
+    ++pos;
+    return node_t{NODE_LITERAL, string(1, c), {}};
+}
+
+MHPP("private static")
+// drops (?: ... ) groups, flattens nested sequences and alternations, merges adjacent literals. str() adds groups where the syntax requires them
+void myRegexAst::simplify(myRegexAst::node_t& n) {
+    for (node_t& c : n.children)
+        simplify(c);
+    if (n.type == NODE_GROUP) {
+        node_t c = std::move(n.children[0]);
+        n = std::move(c);
+        return;
+    }
+    if ((n.type != NODE_CONCAT) && (n.type != NODE_ALT)) return;
+
+    vector<node_t> flat;
+    auto append = [&](node_t&& c) {
+        if ((n.type == NODE_CONCAT) && (c.type == NODE_LITERAL) && (flat.size() > 0) && (flat.back().type == NODE_LITERAL))
+            flat.back().text += c.text;
+        else
+            flat.push_back(std::move(c));
+    };
+    for (node_t& c : n.children) {
+        if (c.type == n.type) {
+            for (node_t& cc : c.children)
+                append(std::move(cc));
+        } else {
+            append(std::move(c));
+        }
+    }
+    n.children = std::move(flat);
+    if (n.children.size() == 1) {
+        node_t c = std::move(n.children[0]);
+        n = std::move(c);
+    }
+}
+
+MHPP("private static")
+void myRegexAst::factorPrefixes(myRegexAst::node_t& n) {
+    for (node_t& c : n.children)
+        factorPrefixes(c);
+    if (n.type != NODE_ALT) return;
+
+    vector<node_t> res;
+    size_t ix = 0;
+    while (ix < n.children.size()) {
+        // === longest run of alternatives with a common literal prefix ===
+        string common = leadingText(n.children[ix]);
+        size_t ixEnd = ix + 1;
+        while ((common.size() > 0) && (ixEnd < n.children.size())) {
+            const string next = leadingText(n.children[ixEnd]);
+            size_t len = 0;
+            while ((len < common.size()) && (len < next.size()) && (common[len] == next[len]))
+                ++len;
+            if (len == 0) break;
+            common.resize(len);
+            ++ixEnd;
+        }
+        if (ixEnd - ix < 2) {
+            res.push_back(std::move(n.children[ix++]));
+            continue;
+        }
+
+        // === prefix(?:rest1|rest2|...) ===
+        node_t rest{NODE_ALT, "", {}};
+        for (; ix < ixEnd; ++ix) {
+            stripLeadingText(n.children[ix], common.size());
+            rest.children.push_back(std::move(n.children[ix]));
+        }
+        factorPrefixes(rest);
+        res.push_back(node_t{NODE_CONCAT, "", {node_t{NODE_LITERAL, common, {}}, rest}});
+    }
+    n.children = std::move(res);
+    if (n.children.size() == 1) {
+        node_t c = std::move(n.children[0]);
+        n = std::move(c);
+    }
+}
+
+MHPP("private static")
+std::string myRegexAst::str(const myRegexAst::node_t& n) {
+    switch (n.type) {
+        case NODE_LITERAL: {
+            static const string metacharacters = R"(\.^$-+()[]{}|?*)";
+            string r;
+            for (char c : n.text) {
+                if (c == '\n')
+                    r += "\\n";
+                else if (c == '\r')
+                    r += "\\r";
+                else if (c == '\t')
+                    r += "\\t";
+                else if (c == '\f')
+                    r += "\\f";
+                else if (c == '\v')
+                    r += "\\v";
+                else if (metacharacters.find(c) != string::npos)
+                    r += string("\\") + c;
+                else
+                    r += c;
+            }
+            return r;
+        }
+        case NODE_ATOM:
+            return n.text;
+        case NODE_CONCAT: {
+            string r;
+            for (const node_t& c : n.children)
+                r += (c.type == NODE_ALT) ? "(?:" + str(c) + ")" : str(c);
+            return r;
+        }
+        case NODE_ALT: {
+            string r;
+            for (size_t ix = 0; ix < n.children.size(); ++ix)
+                r += ((ix > 0) ? "|" : "") + str(n.children[ix]);
+            return r;
+        }
+        case NODE_GROUP:
+            return "(?:" + str(n.children[0]) + ")";
+        case NODE_CAPTURE:
+            return "(" + str(n.children[0]) + ")";
+        case NODE_REPEAT: {
+            const node_t& c = n.children[0];
+            const bool isAtom = (c.type == NODE_ATOM) || (c.type == NODE_GROUP) || (c.type == NODE_CAPTURE) || ((c.type == NODE_LITERAL) && (c.text.size() == 1));
+            return (isAtom ? str(c) : "(?:" + str(c) + ")") + n.text;
+        }
+    }
+    throw runtime_error("myRegexAst: invalid node type");
+}
+
+MHPP("private static")
+void myRegexAst::collectNames(const myRegexAst::node_t& n, std::vector<std::string>& names) {
+    if (n.type == NODE_CAPTURE)
+        names.push_back(n.text);
+    for (const node_t& c : n.children)
+        collectNames(c, names);
+}
+
+MHPP("private static")
+void myRegexAst::dump(const myRegexAst::node_t& n, size_t depth, std::string& out) {
+    static const char* typeNames[] = {"literal", "atom", "concat", "alt", "group", "capture", "repeat"};
+    out += string(2 * depth, ' ') + typeNames[n.type];
+    if (n.type == NODE_LITERAL)
+        out += " " + str(n);
+    else if (n.type != NODE_CONCAT && n.type != NODE_ALT && n.type != NODE_GROUP)
+        out += " " + n.text;
+    out += "\n";
+    for (const node_t& c : n.children)
+        dump(c, depth + 1, out);
+}
+
+MHPP("private static")
+void myRegexAst::removeCaptures(myRegexAst::node_t& n, const std::vector<std::string>& keep) {
+    if ((n.type == NODE_CAPTURE) && (std::find(keep.begin(), keep.end(), n.text) == keep.end())) {
+        n.type = NODE_GROUP;
+        n.text.clear();
+    }
+    for (node_t& c : n.children)
+        removeCaptures(c, keep);
+}
+
+MHPP("private static")
+// fixed texts around node n: isExact if n matches only text; prefix/suffix of every match; best: longest text in every match
+void myRegexAst::literalInfo(const myRegexAst::node_t& n, bool& isExact, std::string& prefix, std::string& suffix, std::string& best) {
+    auto longer = [](const string& a, const string& b) { return (b.size() > a.size()) ? b : a; };
+    switch (n.type) {
+        case NODE_LITERAL:
+            isExact = true;
+            prefix = suffix = best = n.text;
+            return;
+        case NODE_ATOM:
+            // zero-width assertions match the empty text
+            isExact = (n.text == "^") || (n.text == "$") || (n.text == "\\b") || (n.text == "\\B");
+            prefix = suffix = best = "";
+            return;
+        case NODE_GROUP:
+        case NODE_CAPTURE:
+            literalInfo(n.children[0], isExact, prefix, suffix, best);
+            return;
+        case NODE_REPEAT:
+            if (minCount(n.text) == 0) {
+                isExact = false;
+                prefix = suffix = best = "";
+                return;
+            }
+            literalInfo(n.children[0], isExact, prefix, suffix, best);
+            isExact = false;
+            return;
+        case NODE_ALT: {
+            for (size_t ix = 0; ix < n.children.size(); ++ix) {
+                bool e;
+                string p;
+                string s;
+                string b;
+                literalInfo(n.children[ix], e, p, s, b);
+                if (ix == 0) {
+                    isExact = e;
+                    prefix = p;
+                    suffix = s;
+                    best = b;
+                    continue;
+                }
+                isExact = isExact && e && (p == prefix);
+                size_t len = 0;
+                while ((len < prefix.size()) && (len < p.size()) && (prefix[len] == p[len]))
+                    ++len;
+                prefix.resize(len);
+                len = 0;
+                while ((len < suffix.size()) && (len < s.size()) && (suffix[suffix.size() - 1 - len] == s[s.size() - 1 - len]))
+                    ++len;
+                suffix.erase(0, suffix.size() - len);
+                if (b != best) best = "";
+            }
+            best = longer(best, longer(prefix, suffix));
+            return;
+        }
+        case NODE_CONCAT: {
+            isExact = true;
+            best = "";
+            string run;  // exact text since the last inexact child
+            for (const node_t& c : n.children) {
+                bool e;
+                string p;
+                string s;
+                string b;
+                literalInfo(c, e, p, s, b);
+                if (e) {
+                    run += p;
+                    continue;
+                }
+                if (isExact) prefix = run + p;
+                isExact = false;
+                best = longer(best, longer(run + p, b));
+                run = s;
+            }
+            if (isExact) prefix = run;
+            suffix = run;
+            best = longer(best, run);
+            return;
+        }
+    }
+}
+
+MHPP("private static")
+// possible starts of a match of n. false if unknown (or possibly empty)
+bool myRegexAst::leadingLiterals(const myRegexAst::node_t& n, std::vector<std::string>& leads) {
+    leads.clear();
+    switch (n.type) {
+        case NODE_LITERAL:
+            leads.push_back(n.text);
+            break;
+        case NODE_ATOM:
+            return false;
+        case NODE_GROUP:
+        case NODE_CAPTURE:
+            return leadingLiterals(n.children[0], leads);
+        case NODE_REPEAT:
+            if (minCount(n.text) == 0) return false;
+            return leadingLiterals(n.children[0], leads);
+        case NODE_ALT:
+            for (const node_t& c : n.children) {
+                vector<string> l;
+                if (!leadingLiterals(c, l)) return false;
+                leads.insert(leads.end(), l.begin(), l.end());
+            }
+            break;
+        case NODE_CONCAT: {
+            // === exact children extend all leads, the first inexact child multiplies them by its own (if known) ===
+            leads.push_back("");
+            for (const node_t& c : n.children) {
+                bool isExact;
+                string prefix;
+                string suffix;
+                string best;
+                literalInfo(c, isExact, prefix, suffix, best);
+                if (isExact) {
+                    for (string& l : leads)
+                        l += prefix;
+                    continue;
+                }
+                vector<string> l;
+                if (leadingLiterals(c, l) && (leads.size() * l.size() <= MAXLEADS)) {
+                    vector<string> combined;
+                    for (const string& a : leads)
+                        for (const string& b : l)
+                            combined.push_back(a + b);
+                    leads = combined;
+                }
+                break;
+            }
+            break;
+        }
+    }
+    for (const string& l : leads)
+        if (l.size() == 0) return false;
+    return (leads.size() > 0) && (leads.size() <= MAXLEADS);
+}
+
+MHPP("private static")
+// minimum repetition count of a quantifier
+size_t myRegexAst::minCount(const std::string& quantifier) {
+    if (quantifier[0] == '+') return 1;
+    if (quantifier[0] == '{') return std::stoul(quantifier.substr(1));
+    return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// expression tree of a myRegexBase pattern (ECMAScript subset, see myRegexNfa), for optimizer passes before the pattern reaches the engine.
+// Patterns are composed as text (at compile time, see myRegexCt), the tree is parsed from it. str() turns it back into an expression, grouping only where needed
+class myRegexAst {
+   public:
+    // node types
+    typedef enum {
+        // fixed text (unescaped characters)
+        NODE_LITERAL,
+        // character class, set escape (\s etc), '.', or zero-width '^', '$' (expression text)
+        NODE_ATOM,
+        // children in sequence
+        NODE_CONCAT,
+        // children as alternatives, first match wins
+        NODE_ALT,
+        // (?: ... ) around one child
+        NODE_GROUP,
+        // ( ... ) around one child, with capture name
+        NODE_CAPTURE,
+        // one child with quantifier e.g. "*?" or "{2,3}"
+        NODE_REPEAT
+    } node_e;
+    // one tree node. text: literal characters, atom expression, capture name or quantifier
+    struct node_t {
+        node_e type;
+        std::string text;
+        std::vector<node_t> children;
+    };
+    MHPP("begin myRegexAst") // === autogenerated code. Do not edit ===
+    public:
+    	// parses expr with capture names in order of appearance (as myRegexBase). Throws on unsupported syntax
+    	myRegexAst(const std::string& expr, const std::vector<std::string>& captureNames);
+    	// regex expression of the (optimized) tree
+    	std::string str() const;
+    	// capture names in order of appearance, which is the capture numbering
+    	std::vector<std::string> getNames() const;
+    	// one line per node, indented by depth
+    	std::string dump() const;
+    	// turns captures not listed in keep into (?: ... ) groups. Renumbers the remaining captures
+    	void removeCaptures(const std::vector<std::string>& keep);
+    	// factors a common literal prefix out of adjacent alternatives e.g. ab|ac|d => a(?:b|c)|d. Same matches, captures unchanged.
+    	// Only literal prefixes are factored: a prefix that can match in more than one way would change which alternative wins
+    	void factorPrefixes();
+    	// longest text that every match contains (empty if none)
+    	std::string requiredLiteral() const;
+    	// texts one of which every match starts with (empty if any match may start differently). Usable as anchors for myRegexRange::forEachMatch
+    	std::vector<std::string> leadingLiterals() const;
+    	// checks parser, passes and str() against std::regex. Throws on mismatch
+    	static void testcases();
+    private:
+    	// alternation at pos, up to ')' or end
+    	myRegexAst::node_t parseAlt(size_t& pos);
+    	// sequence of quantified atoms at pos, up to '|', ')' or end
+    	myRegexAst::node_t parseConcat(size_t& pos);
+    	// group, character class, escape or single character at pos
+    	myRegexAst::node_t parseAtom(size_t& pos);
+    	// drops (?: ... ) groups, flattens nested sequences and alternations, merges adjacent literals. str() adds groups where the syntax requires them
+    	static void simplify(myRegexAst::node_t& n);
+    	static void factorPrefixes(myRegexAst::node_t& n);
+    	static std::string str(const myRegexAst::node_t& n);
+    	static void collectNames(const myRegexAst::node_t& n, std::vector<std::string>& names);
+    	static void dump(const myRegexAst::node_t& n, size_t depth, std::string& out);
+    	static void removeCaptures(myRegexAst::node_t& n, const std::vector<std::string>& keep);
+    	// fixed texts around node n: isExact if n matches only text; prefix/suffix of every match; best: longest text in every match
+    	static void literalInfo(const myRegexAst::node_t& n, bool& isExact, std::string& prefix, std::string& suffix, std::string& best);
+    	// possible starts of a match of n. false if unknown (or possibly empty)
+    	static bool leadingLiterals(const myRegexAst::node_t& n, std::vector<std::string>& leads);
+    	// minimum repetition count of a quantifier
+    	static size_t minCount(const std::string& quantifier);
+    MHPP("end myRegexAst")
+   private:
+    // expression being parsed (empty afterwards)
+    std::string expr;
+    // capture names by number - 1, while parsing
+    std::vector<std::string> names;
+    // captures opened so far, while parsing
+    size_t nCaptures;
+    node_t root;
+};
@@ -6,6 +6,8 @@
 #include <iterator>
 #include <set>
 #include <stdexcept>
+
+#include "regexRegistry.h"
 using std::string, std::map, std::to_string, std::runtime_error, std::vector, std::smatch, std::ssub_match, std::pair, std::cout, std::endl, std::set;
 
 // ==========================
@@ -89,7 +91,7 @@ myRegexBase myRegexBase::capture(const std::string& captName, const myRegexBase&
 }
 
 MHPP("public static")
-std::string myRegexBase::replaceAll(std::string text, const std::regex r, const std::string& repl) {
+std::string myRegexBase::replaceAll(std::string text, const std::regex& r, const std::string& repl) {
     while (true) {
         string tmp = std::regex_replace(text, r, repl);
         if (tmp == text) return text;
@@ -116,9 +118,29 @@ std::vector<std::string> myRegexBase::split(const std::string& arg, const std::r
     return r;
 }
 
+MHPP("public static")
+// selects the engine myRegexRange uses for myRegexBase arguments. Call before starting threads
+void myRegexBase::setEngine(engine_e engine) { myRegexBase::engine = engine; }
+
+MHPP("public static")
+myRegexBase::engine_e myRegexBase::getEngine() { return engine; }
+
+MHPP("private static")
+// see setEngine()
+myRegexBase::engine_e myRegexBase::engine = ENGINE_STD;
+
 MHPP("public")
 const std::vector<std::string> myRegexBase::getNames() const { return captureNames; }
 
+MHPP("public")
+// capture number of name (0 is the whole match) in results by position e.g. myRegexRange::forEachMatch. Resolve once, not per match
+size_t myRegexBase::captureIndex(const std::string& name) const {
+    for (size_t ix = 0; ix < captureNames.size(); ++ix)
+        if (captureNames[ix] == name)
+            return ix + 1;
+    throw runtime_error("Named capture '" + name + "' not found");
+}
+
 MHPP("public")
 std::string myRegexBase::getNamedCapture(const std::string& name, const std::smatch& m) const {
     const size_t nNames = captureNames.size();
@@ -150,11 +172,17 @@ myRegexBase myRegexBase::operator|(const myRegexBase& arg) const {
     return r;
 }
 
-// converts to STL regex
-myRegexBase::operator std::regex() const {  // FIXME support this
+// converts to STL regex (compiled once per process, see regexRegistry)
+myRegexBase::operator std::regex() const {
+    return getRegex();
+}
+
+MHPP("public")
+// compiled STL regex, shared via regexRegistry
+const std::regex& myRegexBase::getRegex() const {
     const set<string> captNamesUnique(captureNames.begin(), captureNames.end());
     assert(captNamesUnique.size() == captureNames.size() && "duplicate capture names");
-    return std::regex(getExpr());
+    return regexRegistry::get(expr);
 }
 
 MHPP("public")
@@ -163,6 +191,23 @@ std::string myRegexBase::getExpr() const {
     return expr;
 }
 
+MHPP("public")
+// expression tree for inspection and optimizer passes
+myRegexAst myRegexBase::getAst() const {
+    return myRegexAst(expr, captureNames);
+}
+
+MHPP("public")
+// same matches with fewer captures (only usedCaptures, renumbered) and common literal prefixes of alternatives factored out
+myRegexBase myRegexBase::optimized(const std::vector<std::string>& usedCaptures) const {
+    myRegexAst ast = getAst();
+    ast.removeCaptures(usedCaptures);
+    ast.factorPrefixes();
+    myRegexBase r(ast.str(), PRIO_UNKNOWN);
+    r.captureNames = ast.getNames();
+    return r;
+}
+
 MHPP("public static")
 myRegexBase myRegexBase::makeGrp(const myRegexBase& arg) {
     return arg.makeGrp();
@@ -5,8 +5,13 @@
 #include <tuple>
 #include <vector>
 
+#include "myRegexAst.h"
+
 #define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
 
+template <size_t CAP>
+class myRegexCt;
+
 // Regex wrapper with named captures using C++17 STL regex only.
 // Note that code inside a derived class has direct access to members, without requiring any qualifying text input, which allows for concise and readable code.
 class myRegexBase {
@@ -25,6 +30,14 @@ class myRegexBase {
         PRIO_GRP
     } prio_e;
 
+    // matching engine for myRegexBase arguments to myRegexRange
+    typedef enum {
+        // std::regex (backtracking)
+        ENGINE_STD,
+        // myRegexNfa (linear time)
+        ENGINE_NFA
+    } engine_e;
+
     MHPP("begin myRegexBase") // === autogenerated code. Do not edit ===
     public:
     	// match a literal text (escaping regex metacharacters)
@@ -42,24 +55,41 @@ class myRegexBase {
     	static myRegexBase zeroOrOne(const myRegexBase& arg);
     	static myRegexBase zeroOrOne_lazy(const myRegexBase& arg);
     	static myRegexBase capture(const std::string& captName, const myRegexBase& arg);
-    	static std::string replaceAll(std::string text, const std::regex r, const std::string& repl);
+    	static std::string replaceAll(std::string text, const std::regex& r, const std::string& repl);
     	// splits a string item using regex
     	static std::vector<std::string> split(const std::string& arg, const std::regex& rx);
+    	// selects the engine myRegexRange uses for myRegexBase arguments. Call before starting threads
+    	static void setEngine(engine_e engine);
+    	static myRegexBase::engine_e getEngine();
     	const std::vector<std::string> getNames() const;
+    	// capture number of name (0 is the whole match) in results by position e.g. myRegexRange::forEachMatch. Resolve once, not per match
+    	size_t captureIndex(const std::string& name) const;
     	std::string getNamedCapture(const std::string& name, const std::smatch& m) const;
     	myRegexBase operator+(const myRegexBase& arg) const;
     	myRegexBase operator|(const myRegexBase& arg) const;
+    	// compiled STL regex, shared via regexRegistry
+    	const std::regex& getRegex() const;
     	// returns content as regex string
     	std::string getExpr() const;
+    	// expression tree for inspection and optimizer passes
+    	myRegexAst getAst() const;
+    	// same matches with fewer captures (only usedCaptures, renumbered) and common literal prefixes of alternatives factored out
+    	myRegexBase optimized(const std::vector<std::string>& usedCaptures) const;
     	static myRegexBase makeGrp(const myRegexBase& arg);
     	myRegexBase makeGrp() const;
     protected:
     	myRegexBase(const std::string& expr, prio_e prio);
     	// replaces internal regex, keeps named captures
     	myRegexBase changeExpr(const std::string& newExpr, prio_e newPrio) const;
+    private:
+    	// see setEngine()
+    	static myRegexBase::engine_e engine;
     MHPP("end myRegexBase")
    public:
     operator std::regex() const;
+    // from a pattern composed at compile time (defined in myRegexCt.h)
+    template <size_t CAP>
+    myRegexBase(const myRegexCt<CAP>& ct);
 
    protected:
     // expression in human-readable regex format
@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "myRegexBase.h"
+
+// regex expression composed in constant expressions, following the same rules as myRegexBase (identical expression text and capture names).
+// Patterns built from literals are complete at compile time: no string concatenation at startup, capture indices resolve via captureIndex().
+// CAP bounds the expression length. Composition returns a type with sufficient capacity. Convert to myRegexBase for runtime use.
+template <size_t CAP>
+class myRegexCt {
+   public:
+    // maximum number of named captures
+    static constexpr size_t MAXNAMES = 16;
+
+    constexpr myRegexCt() : expr{}, len(0), prio(myRegexBase::PRIO_UNKNOWN), names{}, nNames(0) {}
+
+    // widening copy
+    template <size_t C2>
+    constexpr myRegexCt(const myRegexCt<C2>& arg) : myRegexCt() {
+        static_assert(C2 <= CAP, "narrowing myRegexCt");
+        append(arg.expr, arg.len);
+        prio = arg.prio;
+        appendNames(arg);
+    }
+
+    constexpr myRegexCt<CAP + 4> makeGrp() const {
+        myRegexCt<CAP + 4> r;
+        appendOperand(r, /*asIs*/ prio >= myRegexBase::PRIO_GRP);
+        r.prio = myRegexBase::PRIO_GRP;
+        return r;
+    }
+
+    template <size_t C2>
+    constexpr myRegexCt<CAP + C2 + 8> operator+(const myRegexCt<C2>& arg) const {
+        myRegexCt<CAP + C2 + 8> r;
+        appendOperand(r, prio >= myRegexBase::PRIO_CONCAT);
+        arg.appendOperand(r, arg.prio >= myRegexBase::PRIO_CONCAT);
+        r.prio = myRegexBase::PRIO_CONCAT;
+        return r;
+    }
+
+    template <size_t C2>
+    constexpr myRegexCt<CAP + C2 + 9> operator|(const myRegexCt<C2>& arg) const {
+        // special case: if an argument is an alternation at toplevel, it can be appended without need for grouping
+        myRegexCt<CAP + C2 + 9> r;
+        appendOperand(r, (prio == myRegexBase::PRIO_OR) || (prio >= myRegexBase::PRIO_GRP));
+        r.append("|", 1);
+        arg.appendOperand(r, (arg.prio == myRegexBase::PRIO_OR) || (arg.prio >= myRegexBase::PRIO_GRP));
+        r.prio = myRegexBase::PRIO_OR;
+        return r;
+    }
+
+    // capture group number of name (1-based as in std::smatch). Fails compilation in a constant expression if not found
+    constexpr size_t captureIndex(const char* name) const {
+        for (size_t ix = 0; ix < nNames; ++ix)
+            if (equals(names[ix], name)) return ix + 1;
+        throw std::runtime_error("myRegexCt: named capture '" + std::string(name) + "' not found");
+    }
+
+    // returns content as regex string
+    std::string str() const { return std::string(expr, len); }
+    std::vector<std::string> getNames() const { return std::vector<std::string>(names, names + nNames); }
+
+    // appends text to the expression
+    constexpr void append(const char* text, size_t n) {
+        if (len + n > CAP) throw std::runtime_error("myRegexCt: capacity exceeded");
+        for (size_t ix = 0; ix < n; ++ix)
+            expr[len++] = text[ix];
+    }
+
+    // appends this expression to dest, enclosed in (?: ... ) unless asIs. Includes capture names
+    template <size_t C2>
+    constexpr void appendOperand(myRegexCt<C2>& dest, bool asIs) const {
+        if (!asIs) dest.append("(?:", 3);
+        dest.append(expr, len);
+        if (!asIs) dest.append(")", 1);
+        dest.appendNames(*this);
+    }
+
+    template <size_t C2>
+    constexpr void appendNames(const myRegexCt<C2>& arg) {
+        if (nNames + arg.nNames > MAXNAMES) throw std::runtime_error("myRegexCt: too many named captures");
+        for (size_t ix = 0; ix < arg.nNames; ++ix)
+            names[nNames++] = arg.names[ix];
+    }
+
+    // (not zero terminated)
+    char expr[CAP];
+    size_t len;
+    myRegexBase::prio_e prio;
+    // named captures in order of appearance (string literals)
+    const char* names[MAXNAMES];
+    size_t nNames;
+
+   private:
+    static constexpr bool equals(const char* a, const char* b) {
+        while ((*a != 0) && (*a == *b)) {
+            ++a;
+            ++b;
+        }
+        return *a == *b;
+    }
+};
+
+// builders for myRegexCt, see the same-named functions in myRegexBase
+class myRegexCtBase {
+   public:
+    // match a literal text (escaping regex metacharacters)
+    template <size_t N>
+    static constexpr myRegexCt<2 * N> txt(const char (&text)[N]) {
+        constexpr char metacharacters[] = R"(\.^$-+()[]{}|?*)";
+        myRegexCt<2 * N> r;
+        for (size_t ix = 0; ix + 1 < N; ++ix) {
+            for (char m : metacharacters)
+                if ((m != 0) && (m == text[ix])) r.append("\\", 1);
+            r.append(&text[ix], 1);
+        }
+        r.prio = myRegexBase::PRIO_CONCAT;
+        return r;
+    }
+
+    // create arbitrary regex. Most generic variant, assumes reuse needs to wrap in (?: ...)
+    template <size_t N>
+    static constexpr myRegexCt<N> rx(const char (&re)[N]) { return literal(re, myRegexBase::PRIO_UNKNOWN); }
+
+    // create regex, special case for an alternation e.g. one|two|three at toplevel
+    template <size_t N>
+    static constexpr myRegexCt<N> rx_alt(const char (&re)[N]) { return literal(re, myRegexBase::PRIO_OR); }
+
+    // create regex, special case for a group e.g. (...), (?:...) at toplevel
+    template <size_t N>
+    static constexpr myRegexCt<N> rx_grp(const char (&re)[N]) { return literal(re, myRegexBase::PRIO_GRP); }
+
+    template <size_t C>
+    static constexpr myRegexCt<C + 5> zeroOrMore(const myRegexCt<C>& arg) { return suffix(arg, "*"); }
+    template <size_t C>
+    static constexpr myRegexCt<C + 6> zeroOrMore_lazy(const myRegexCt<C>& arg) { return suffix(arg, "*?"); }
+    template <size_t C>
+    static constexpr myRegexCt<C + 5> oneOrMore(const myRegexCt<C>& arg) { return suffix(arg, "+"); }
+    template <size_t C>
+    static constexpr myRegexCt<C + 6> oneOrMore_lazy(const myRegexCt<C>& arg) { return suffix(arg, "+?"); }
+    template <size_t C>
+    static constexpr myRegexCt<C + 5> zeroOrOne(const myRegexCt<C>& arg) { return suffix(arg, "?"); }
+    template <size_t C>
+    static constexpr myRegexCt<C + 6> zeroOrOne_lazy(const myRegexCt<C>& arg) { return suffix(arg, "??"); }
+
+    // captName must be a string literal (it is referenced, not copied)
+    template <size_t C>
+    static constexpr myRegexCt<C + 2> capture(const char* captName, const myRegexCt<C>& arg) {
+        myRegexCt<C + 2> r;
+        r.names[r.nNames++] = captName;  // at head as we're wrapping the expression
+        r.append("(", 1);
+        r.append(arg.expr, arg.len);
+        r.append(")", 1);
+        r.appendNames(arg);
+        r.prio = myRegexBase::PRIO_GRP;
+        return r;
+    }
+
+    template <size_t C>
+    static constexpr myRegexCt<C + 4> makeGrp(const myRegexCt<C>& arg) { return arg.makeGrp(); }
+
+   private:
+    template <size_t N>
+    static constexpr myRegexCt<N> literal(const char (&re)[N], myRegexBase::prio_e prio) {
+        myRegexCt<N> r;
+        r.append(re, N - 1);
+        r.prio = prio;
+        return r;
+    }
+
+    // arg (grouped if needed) followed by a quantifier of one or two characters
+    template <size_t C, size_t N>
+    static constexpr myRegexCt<C + 3 + N> suffix(const myRegexCt<C>& arg, const char (&quantifier)[N]) {
+        myRegexCt<C + 3 + N> r(arg.makeGrp());
+        r.append(quantifier, N - 1);
+        r.prio = myRegexBase::PRIO_REP;
+        return r;
+    }
+};
+
+template <size_t CAP>
+myRegexBase::myRegexBase(const myRegexCt<CAP>& ct) : expr(ct.str()), prio(ct.prio), captureNames(ct.getNames()) {}
@@ -0,0 +1,261 @@
+#include "myRegexNfa.h"
+
+#include <algorithm>
+#include <regex>
+#include <stdexcept>
+
+#include "myRegexNfaCompiler.h"
+using std::string, std::vector, std::runtime_error, std::to_string;
+
+// store_t for myRegexNfaCompiler, appending to myRegexNfa's vectors
+class nfaVectorStore {
+   public:
+    nfaVectorStore(vector<myRegexNfa::inst_t>& prog, vector<myRegexNfa::charClass_t>& charClasses, size_t& nGroups) : prog(prog), charClasses(charClasses), nGroups(nGroups) {}
+    uint32_t append(myRegexNfa::op_e op, uint32_t x, uint32_t y) {
+        prog.push_back(myRegexNfa::inst_t{op, x, y});
+        return prog.size() - 1;
+    }
+    myRegexNfa::inst_t& at(uint32_t ix) { return prog[ix]; }
+    size_t size() const { return prog.size(); }
+    uint32_t addClass(const myRegexNfa::charClass_t& c) {
+        charClasses.push_back(c);
+        return charClasses.size() - 1;
+    }
+    void setNGroups(size_t n) { nGroups = n; }
+
+   private:
+    vector<myRegexNfa::inst_t>& prog;
+    vector<myRegexNfa::charClass_t>& charClasses;
+    size_t& nGroups;
+};
+
+// ===========================
+// === myRegexNfa public ===
+// ===========================
+
+MHPP("public")
+// compiles expr (as created by myRegexBase). Throws on unsupported syntax
+myRegexNfa::myRegexNfa(const std::string& expr) : ownProg(), ownCharClasses(), program() {
+    nfaVectorStore store(ownProg, ownCharClasses, program.nGroups);
+    myRegexNfaCompiler<nfaVectorStore>(expr.data(), expr.size(), store).compile();
+    program.prog = ownProg.data();
+    program.nInst = ownProg.size();
+    program.charClasses = ownCharClasses.data();
+}
+
+MHPP("public")
+// uses a program compiled at build time (see myRegexNfaCt), which must outlive this object
+myRegexNfa::myRegexNfa(const myRegexNfa::program_t& program) : ownProg(), ownCharClasses(), program(program) {}
+
+MHPP("public")
+// number of capture groups, including the full match as group 0
+size_t myRegexNfa::getNGroups() const { return program.nGroups; }
+
+MHPP("public")
+// like std::regex_match: whole range must match. slots receives begin/end of each group (unmatched: end, end)
+bool myRegexNfa::match(const char* begin, const char* end, std::vector<const char*>& slots) const {
+    return run(begin, end, begin, /*anchorStart*/ true, /*anchorEnd*/ true, slots);
+}
+
+MHPP("public")
+// like std::regex_search with match_continuous: the match must start at from, may end anywhere. slots as in match()
+bool myRegexNfa::matchAt(const char* begin, const char* end, const char* from, std::vector<const char*>& slots) const {
+    return run(begin, end, from, /*anchorStart*/ true, /*anchorEnd*/ false, slots);
+}
+
+MHPP("public")
+// like std::regex_search on [from, end) with begin as beginning of input: leftmost match, highest priority path. slots as in match()
+bool myRegexNfa::search(const char* begin, const char* end, const char* from, std::vector<const char*>& slots) const {
+    return run(begin, end, from, /*anchorStart*/ false, /*anchorEnd*/ false, slots);
+}
+
+// thread list of one VM step: set of instructions in priority order (including visited zero-width ones), with capture slots per instruction
+class nfaThreadList {
+   public:
+    nfaThreadList() : nSlots(0), dense(), sparse(), n(0), slots() {}
+    // empties the list for a program of nInst instructions. Storage only grows (lists are reused across calls, see myRegexNfa::run)
+    void reset(size_t nInst, size_t nSlots) {
+        this->nSlots = nSlots;
+        if (dense.size() < nInst) {
+            dense.resize(nInst);
+            sparse.resize(nInst);
+        }
+        if (slots.size() < nInst * nSlots) slots.resize(nInst * nSlots);
+        n = 0;
+    }
+    bool contains(uint32_t pc) const { return (sparse[pc] < n) && (dense[sparse[pc]] == pc); }
+    void insert(uint32_t pc) {
+        sparse[pc] = n;
+        dense[n++] = pc;
+    }
+    void clear() { n = 0; }
+    size_t size() const { return n; }
+    uint32_t pcAt(size_t ix) const { return dense[ix]; }
+    const char** slotsOf(uint32_t pc) { return &slots[pc * nSlots]; }
+    size_t getNSlots() const { return nSlots; }
+
+   private:
+    size_t nSlots;
+    vector<uint32_t> dense;
+    vector<uint32_t> sparse;
+    size_t n;
+    vector<const char*> slots;
+};
+
+// follows zero-width instructions from pc at position p, adding the resulting consuming (or matching) threads to list in priority order
+static void addThread(const myRegexNfa::inst_t* prog, nfaThreadList& list, uint32_t pc, const char* p, const char* begin, const char* end, const char** slots) {
+    if (list.contains(pc)) return;  // a higher-priority thread got there first
+    list.insert(pc);
+    const myRegexNfa::inst_t& inst = prog[pc];
+    switch (inst.op) {
+        case myRegexNfa::OP_JMP:
+            addThread(prog, list, inst.x, p, begin, end, slots);
+            return;
+        case myRegexNfa::OP_SPLIT:
+            addThread(prog, list, inst.x, p, begin, end, slots);
+            addThread(prog, list, inst.y, p, begin, end, slots);
+            return;
+        case myRegexNfa::OP_SAVE: {
+            const char* old = slots[inst.x];
+            slots[inst.x] = p;
+            addThread(prog, list, pc + 1, p, begin, end, slots);
+            slots[inst.x] = old;
+            return;
+        }
+        case myRegexNfa::OP_BOL:
+            if (p == begin) addThread(prog, list, pc + 1, p, begin, end, slots);
+            return;
+        case myRegexNfa::OP_EOL:
+            if (p == end) addThread(prog, list, pc + 1, p, begin, end, slots);
+            return;
+        case myRegexNfa::OP_CHAR:
+        case myRegexNfa::OP_MATCH:
+            std::copy(slots, slots + list.getNSlots(), list.slotsOf(pc));
+            return;
+    }
+}
+
+MHPP("private")
+// Pike VM over [begin, end), starting at from. anchorStart: match must start at from, otherwise leftmost search. anchorEnd: match must end at end
+bool myRegexNfa::run(const char* begin, const char* end, const char* from, bool anchorStart, bool anchorEnd, std::vector<const char*>& slots) const {
+    const inst_t* prog = program.prog;
+    const size_t nSlots = 2 * program.nGroups;
+    // === scratch reused by later calls on the same thread (run() is called per match attempt) ===
+    thread_local nfaThreadList clist;
+    thread_local nfaThreadList nlist;
+    thread_local vector<const char*> work;
+    thread_local vector<const char*> best;
+    clist.reset(program.nInst, nSlots);
+    nlist.reset(program.nInst, nSlots);
+    work.assign(nSlots, nullptr);
+    best.clear();
+
+    for (const char* p = from;; ++p) {
+        // === a new attempt starting at p has lowest priority. None once a match was found (leftmost wins) ===
+        if (best.size() == 0 && (!anchorStart || (p == from))) {
+            std::fill(work.begin(), work.end(), nullptr);
+            addThread(prog, clist, 0, p, begin, end, work.data());
+        }
+        if (clist.size() == 0) break;
+
+        nlist.clear();
+        for (size_t ix = 0; ix < clist.size(); ++ix) {
+            const uint32_t pc = clist.pcAt(ix);
+            const inst_t& inst = prog[pc];
+            const char** s = clist.slotsOf(pc);
+            if (inst.op == OP_MATCH) {
+                if (anchorEnd && (p != end)) continue;
+                best.assign(s, s + nSlots);
+                break;  // lower-priority threads are cut off
+            }
+            if (inst.op != OP_CHAR) continue;  // zero-width instructions were followed by addThread()
+            if ((p != end) && program.charClasses[inst.x].test((unsigned char)*p))
+                addThread(prog, nlist, pc + 1, p + 1, begin, end, s);
+        }
+        std::swap(clist, nlist);
+        if (p == end) break;
+    }
+    if (best.size() == 0) return false;
+
+    // === unmatched groups: end, end (as libstdc++) ===
+    for (size_t ix = 0; ix < nSlots; ix += 2)
+        if ((best[ix] == nullptr) || (best[ix + 1] == nullptr))
+            best[ix] = best[ix + 1] = end;
+    slots = best;
+    return true;
+}
+
+MHPP("public static")
+// compares results with std::regex. Throws on mismatch
+void myRegexNfa::testcases() {
+    const vector<std::pair<string, vector<string>>> cases = {
+        {"a*?b", {"aab", "b", "xaabyb", ""}},
+        {"(a|ab)(c|bcd)(d*)", {"abcd", "abcdd", "xxabcdyy"}},
+        {"([a-c]+?)(b*)", {"abbb", "cb"}},
+        {"x(?:y|z)*?(z)", {"xyzyz", "xz", "x"}},
+        {"[^\\)\\{]*", {"abc)", "{", ""}},
+        {"\\s+(\\S+)\\s*", {"  foo  ", "\tbar\n", "x"}},
+        {"//.*\\r?\\n", {"// c\r\nx", "//\n"}},
+        {"/\\*.*?\\*/", {"/* a */ b */", "/**/"}},
+        {"[\\s\\S]*?end", {"a\nb end end"}},
+        {"a{2,3}", {"aaaa", "a", "aa"}},
+        {"(a{2})+", {"aaaaa"}},
+        {"^ab|b$", {"ab", "cab", "b"}},
+        {"([_a-zA-Z][_a-zA-Z0-9]*)((?:::)[_a-zA-Z][_a-zA-Z0-9]*)*", {"a::b::c", "a:b"}},
+        {"(x)?y", {"y", "xy"}},
+    };
+    for (const auto& [expr, texts] : cases) {
+        const myRegexNfa nfa(expr);
+        const std::regex rx(expr);
+        for (const string& text : texts) {
+            const char* b = text.data();
+            const char* e = b + text.size();
+            auto describe = [&](const string& what) { return "myRegexNfa testcase failed: " + what + " of '" + expr + "' on '" + text + "'"; };
+
+            // === match ===
+            std::cmatch m;
+            vector<const char*> slots;
+            const bool isMatch = std::regex_match(b, e, m, rx);
+            if (isMatch != nfa.match(b, e, slots)) throw runtime_error(describe("match result"));
+            if (isMatch)
+                for (size_t ix = 0; ix < m.size(); ++ix)
+                    if ((m[ix].first != slots[2 * ix]) || (m[ix].second != slots[2 * ix + 1])) throw runtime_error(describe("match group " + to_string(ix)));
+
+            // === match starting at each position ===
+            for (const char* from = b; from <= e; ++from) {
+                const auto flags = std::regex_constants::match_continuous | ((from == b) ? std::regex_constants::match_default : std::regex_constants::match_prev_avail);
+                const bool isMatchAt = std::regex_search(from, e, m, rx, flags);
+                if (isMatchAt != nfa.matchAt(b, e, from, slots)) throw runtime_error(describe("matchAt result"));
+                if (isMatchAt)
+                    for (size_t ix = 0; ix < m.size(); ++ix)
+                        if ((m[ix].first != slots[2 * ix]) || (m[ix].second != slots[2 * ix + 1])) throw runtime_error(describe("matchAt group " + to_string(ix)));
+            }
+
+            // === all matches as by regex_iterator ===
+            const char* cursor = b;
+            for (std::cregex_iterator it(b, e, rx), itEnd; it != itEnd; ++it) {
+                if (!nfa.search(b, e, cursor, slots)) throw runtime_error(describe("search result"));
+                for (size_t ix = 0; ix < it->size(); ++ix)
+                    if (((*it)[ix].first != slots[2 * ix]) || ((*it)[ix].second != slots[2 * ix + 1])) throw runtime_error(describe("search group " + to_string(ix)));
+                cursor = slots[1];
+                if (slots[0] == slots[1]) {
+                    // empty match: std::regex_iterator continues behind it
+                    if (cursor == e) break;
+                    ++cursor;
+                }
+            }
+        }
+    }
+
+    // === program compiled at build time gives the same results ===
+    static constexpr char ctExpr[] = "(a|ab)(c|bcd)(d*)";
+    static constexpr myRegexNfaCt<64, 16> ct(ctExpr, sizeof(ctExpr) - 1);
+    const myRegexNfa nfaCt(ct.getProgram());
+    const myRegexNfa nfaRt(ctExpr);
+    const string text = "xxabcddyy";
+    vector<const char*> slotsCt;
+    vector<const char*> slotsRt;
+    const bool isMatchCt = nfaCt.search(text.data(), text.data() + text.size(), text.data(), slotsCt);
+    const bool isMatchRt = nfaRt.search(text.data(), text.data() + text.size(), text.data(), slotsRt);
+    if (!isMatchCt || !isMatchRt || (slotsCt != slotsRt)) throw runtime_error("myRegexNfa testcase failed: build time compilation of '" + string(ctExpr) + "'");
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// linear-time matcher for the ECMAScript subset used by myRegexBase expressions (Thompson NFA, simulated as Pike VM).
+// Threads are kept in priority order, which gives the same leftmost-first results as backtracking std::regex (greedy and lazy quantifiers),
+// without exponential blowup. Not supported: backreferences, lookahead, word boundaries (the constructor throws).
+// Captures inside a repeated group report the last iteration (std::regex ECMAScript clears them at the start of each iteration).
+class myRegexNfa {
+   public:
+    // VM instruction opcodes
+    typedef enum {
+        // consume one character contained in charClasses[x]
+        OP_CHAR,
+        // continue at x (preferred) and y
+        OP_SPLIT,
+        // continue at x
+        OP_JMP,
+        // record current position in capture slot x
+        OP_SAVE,
+        // zero-width: beginning of input
+        OP_BOL,
+        // zero-width: end of input
+        OP_EOL,
+        OP_MATCH
+    } op_e;
+    // one VM instruction
+    typedef struct {
+        op_e op;
+        uint32_t x;
+        uint32_t y;
+    } inst_t;
+    // set of characters (usable in constant expressions, see myRegexNfaCt)
+    struct charClass_t {
+        uint64_t bits[4] = {0, 0, 0, 0};
+        constexpr void set(unsigned char c) { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+        constexpr void reset(unsigned char c) { bits[c >> 6] &= ~(uint64_t(1) << (c & 63)); }
+        constexpr bool test(unsigned char c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+        constexpr void flip() {
+            for (uint64_t& b : bits) b = ~b;
+        }
+        constexpr charClass_t& operator|=(const charClass_t& arg) {
+            for (size_t ix = 0; ix < 4; ++ix) bits[ix] |= arg.bits[ix];
+            return *this;
+        }
+        constexpr size_t count() const {
+            size_t n = 0;
+            for (int c = 0; c < 256; ++c) n += test(c);
+            return n;
+        }
+        // lowest contained character (-1 if empty)
+        constexpr int first() const {
+            for (int c = 0; c < 256; ++c)
+                if (test(c)) return c;
+            return -1;
+        }
+    };
+    // compiled program (owned by myRegexNfa or a myRegexNfaCt)
+    typedef struct {
+        const inst_t* prog;
+        size_t nInst;
+        const charClass_t* charClasses;
+        // capture groups including group 0
+        size_t nGroups;
+    } program_t;
+    MHPP("begin myRegexNfa") // === autogenerated code. Do not edit ===
+    public:
+    	// compiles expr (as created by myRegexBase). Throws on unsupported syntax
+    	myRegexNfa(const std::string& expr);
+    	// uses a program compiled at build time (see myRegexNfaCt), which must outlive this object
+    	myRegexNfa(const myRegexNfa::program_t& program);
+    	// number of capture groups, including the full match as group 0
+    	size_t getNGroups() const;
+    	// like std::regex_match: whole range must match. slots receives begin/end of each group (unmatched: end, end)
+    	bool match(const char* begin, const char* end, std::vector<const char*>& slots) const;
+    	// like std::regex_search with match_continuous: the match must start at from, may end anywhere. slots as in match()
+    	bool matchAt(const char* begin, const char* end, const char* from, std::vector<const char*>& slots) const;
+    	// like std::regex_search on [from, end) with begin as beginning of input: leftmost match, highest priority path. slots as in match()
+    	bool search(const char* begin, const char* end, const char* from, std::vector<const char*>& slots) const;
+    	// compares results with std::regex. Throws on mismatch
+    	static void testcases();
+    private:
+    	// Pike VM over [begin, end), starting at from. anchorStart: match must start at from, otherwise leftmost search. anchorEnd: match must end at end
+    	bool run(const char* begin, const char* end, const char* from, bool anchorStart, bool anchorEnd, std::vector<const char*>& slots) const;
+    MHPP("end myRegexNfa")
+   private:
+    myRegexNfa(const myRegexNfa&) = delete;
+    myRegexNfa& operator=(const myRegexNfa&) = delete;
+    // compiled by the constructor (empty if the program is compiled at build time)
+    std::vector<inst_t> ownProg;
+    std::vector<charClass_t> ownCharClasses;
+    program_t program;
+};
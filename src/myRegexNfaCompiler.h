@@ -0,0 +1,390 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "myRegexNfa.h"
+
+// translates a regex (ECMAScript subset, see myRegexNfa) into VM code for myRegexNfa. Usable in constant expressions (see myRegexNfaCt).
+// store_t receives the program: uint32_t append(op, x, y), inst_t& at(ix), size_t size(), uint32_t addClass(charClass_t), setNGroups(n).
+// Works directly on the expression text (no syntax tree): atoms are delimited first, then emitted, possibly repeatedly for counted repetition
+template <class store_t>
+class myRegexNfaCompiler {
+   public:
+    typedef myRegexNfa::charClass_t charClass_t;
+    constexpr myRegexNfaCompiler(const char* expr, size_t len, store_t& out) : expr(expr), len(len), out(out) {}
+
+    // compiles the whole expression, with group 0 around it
+    constexpr void compile() {
+        out.setNGroups(groupsBefore(len) + 1);
+        out.append(myRegexNfa::OP_SAVE, 0, 0);
+        alt(0, len);
+        out.append(myRegexNfa::OP_SAVE, 1, 0);
+        out.append(myRegexNfa::OP_MATCH, 0, 0);
+    }
+
+   private:
+    [[noreturn]] void fail(const char* what, size_t pos) const {
+        throw std::runtime_error("regex '" + std::string(expr, len) + "': " + what + " at position " + std::to_string(pos));
+    }
+
+    static constexpr bool isDigit(char c) { return (c >= '0') && (c <= '9'); }
+    static constexpr bool isAlnum(char c) { return isDigit(c) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')); }
+
+    // end of the atom at pos: group, character class, escape or single character (quantifiers count as single characters here)
+    constexpr size_t atomEnd(size_t pos, size_t end) const {
+        const char c = expr[pos];
+        if (c == '\\') {
+            if (pos + 1 >= end) fail("trailing backslash", pos);
+            return pos + 2;
+        }
+        if (c == '[') {
+            size_t p = pos + 1;
+            if ((p < end) && (expr[p] == '^')) ++p;
+            bool first = true;  // ']' as first character is a literal
+            while (true) {
+                if (p >= end) fail("missing ']'", pos);
+                if ((expr[p] == ']') && !first) return p + 1;
+                first = false;
+                p += (expr[p] == '\\') ? 2 : 1;
+            }
+        }
+        if (c == '(') {
+            size_t depth = 0;
+            size_t p = pos;
+            while (p < end) {
+                const char d = expr[p];
+                if ((d == '\\') || (d == '[')) {
+                    p = atomEnd(p, end);
+                    continue;
+                }
+                if (d == '(') ++depth;
+                if ((d == ')') && (--depth == 0)) return p + 1;
+                ++p;
+            }
+            fail("missing ')'", pos);
+        }
+        return pos + 1;
+    }
+
+    // number of capture groups opened before pos (groups are numbered by their opening bracket)
+    constexpr size_t groupsBefore(size_t pos) const {
+        size_t n = 0;
+        size_t p = 0;
+        while (p < pos) {
+            if ((expr[p] == '\\') || (expr[p] == '[')) {
+                p = atomEnd(p, len);
+                continue;
+            }
+            if ((expr[p] == '(') && ((p + 1 >= len) || (expr[p + 1] != '?'))) ++n;
+            ++p;
+        }
+        return n;
+    }
+
+    // emits alternation in [b, e)
+    constexpr void alt(size_t b, size_t e) {
+        // === SPLIT alt1, next; alt1; JMP end; next: SPLIT alt2, next2 ... ===
+        std::array<uint32_t, 64> jumps{};
+        size_t nJumps = 0;
+        size_t branchBegin = b;
+        size_t p = b;
+        while (true) {
+            if ((p < e) && (expr[p] != '|')) {
+                p = atomEnd(p, e);
+                continue;
+            }
+            const bool isLast = (p == e);
+            if (isLast && (nJumps == 0)) {
+                concat(branchBegin, e);  // no alternation
+                return;
+            }
+            uint32_t split = 0;
+            if (!isLast) {
+                split = out.append(myRegexNfa::OP_SPLIT, 0, 0);
+                out.at(split).x = out.size();
+            }
+            concat(branchBegin, p);
+            if (isLast) break;
+            if (nJumps == jumps.size()) fail("too many alternatives", p);
+            jumps[nJumps++] = out.append(myRegexNfa::OP_JMP, 0, 0);
+            out.at(split).y = out.size();
+            branchBegin = ++p;
+        }
+        for (size_t ix = 0; ix < nJumps; ++ix)
+            out.at(jumps[ix]).x = out.size();
+    }
+
+    // emits concatenation of (quantified) atoms in [b, e)
+    constexpr void concat(size_t b, size_t e) {
+        size_t p = b;
+        while (p < e) {
+            const char c = expr[p];
+            if (c == ')') fail("unexpected ')'", p);
+            if ((c == '*') || (c == '+') || (c == '?') || (c == '{')) fail("nothing to repeat", p);
+            const size_t a = atomEnd(p, e);
+
+            // === optional quantifier ===
+            size_t q = a;
+            size_t min = 1;
+            size_t max = 1;
+            if (q < e) {
+                const char d = expr[q];
+                if (d == '*') {
+                    min = 0;
+                    max = SIZE_MAX;
+                    ++q;
+                } else if (d == '+') {
+                    max = SIZE_MAX;
+                    ++q;
+                } else if (d == '?') {
+                    min = 0;
+                    ++q;
+                } else if (d == '{') {
+                    // {n} {n,} {n,m}
+                    ++q;
+                    if ((q >= e) || !isDigit(expr[q])) fail("invalid repetition", a);
+                    min = 0;
+                    while ((q < e) && isDigit(expr[q]))
+                        min = 10 * min + (expr[q++] - '0');
+                    max = min;
+                    if ((q < e) && (expr[q] == ',')) {
+                        ++q;
+                        max = SIZE_MAX;
+                        if ((q < e) && isDigit(expr[q])) {
+                            max = 0;
+                            while ((q < e) && isDigit(expr[q]))
+                                max = 10 * max + (expr[q++] - '0');
+                        }
+                    }
+                    if ((q >= e) || (expr[q] != '}') || (max < min)) fail("invalid repetition", a);
+                    ++q;
+                }
+            }
+            bool greedy = true;
+            if ((q > a) && (q < e) && (expr[q] == '?')) {
+                greedy = false;
+                ++q;
+            }
+            if (q == a)
+                atom(p, a);
+            else
+                repeat(p, a, min, max, greedy);
+            p = q;
+        }
+    }
+
+    // emits atom [b, e) repeated min..max times (max == SIZE_MAX: unbounded)
+    constexpr void repeat(size_t b, size_t e, size_t min, size_t max, bool greedy) {
+        // split towards "one more iteration" or "done", swapped for lazy quantifiers
+        auto setSplit = [&](uint32_t split, uint32_t more, uint32_t done) {
+            out.at(split).x = greedy ? more : done;
+            out.at(split).y = greedy ? done : more;
+        };
+
+        // === mandatory iterations ===
+        for (size_t ix = 0; ix < min; ++ix)
+            atom(b, e);
+
+        if (max == SIZE_MAX) {
+            // === unbounded: loop: SPLIT body, end; body; JMP loop ===
+            const uint32_t loop = out.append(myRegexNfa::OP_SPLIT, 0, 0);
+            atom(b, e);
+            out.append(myRegexNfa::OP_JMP, loop, 0);
+            setSplit(loop, loop + 1, out.size());
+            return;
+        }
+
+        // === optional iterations: SPLIT body, end; body; SPLIT body, end; body; ... end: ===
+        const uint32_t first = out.size();
+        for (size_t ix = min; ix < max; ++ix) {
+            out.append(myRegexNfa::OP_SPLIT, 0, 0);
+            atom(b, e);
+        }
+        if (max == min) return;
+        const uint32_t stride = (out.size() - first) / (max - min);  // all iterations have the same code size
+        for (uint32_t split = first; split < out.size(); split += stride)
+            setSplit(split, split + 1, out.size());
+    }
+
+    // emits group, character class, escape or literal [b, e)
+    constexpr void atom(size_t b, size_t e) {
+        const char c = expr[b];
+        switch (c) {
+            case '(': {
+                if ((b + 1 < e) && (expr[b + 1] == '?')) {
+                    if ((b + 2 >= e) || (expr[b + 2] != ':')) fail("unsupported group", b);
+                    alt(b + 3, e - 1);
+                    return;
+                }
+                const uint32_t ixGroup = groupsBefore(b) + 1;
+                out.append(myRegexNfa::OP_SAVE, 2 * ixGroup, 0);
+                alt(b + 1, e - 1);
+                out.append(myRegexNfa::OP_SAVE, 2 * ixGroup + 1, 0);
+                return;
+            }
+            case '[':
+                out.append(myRegexNfa::OP_CHAR, out.addClass(parseClass(b + 1, e - 1)), 0);
+                return;
+            case '.': {
+                // ECMAScript: anything but line terminators
+                charClass_t set;
+                set.flip();
+                set.reset('\n');
+                set.reset('\r');
+                out.append(myRegexNfa::OP_CHAR, out.addClass(set), 0);
+                return;
+            }
+            case '\\':
+                out.append(myRegexNfa::OP_CHAR, out.addClass(parseEscape(b + 1)), 0);
+                return;
+            case '^':
+                out.append(myRegexNfa::OP_BOL, 0, 0);
+                return;
+            case '$':
+                out.append(myRegexNfa::OP_EOL, 0, 0);
+                return;
+            default: {
+                charClass_t set;
+                set.set((unsigned char)c);
+                out.append(myRegexNfa::OP_CHAR, out.addClass(set), 0);
+                return;
+            }
+        }
+    }
+
+    // character class body [b, e) between '[' and ']'
+    constexpr charClass_t parseClass(size_t b, size_t e) const {
+        charClass_t set;
+        bool negate = false;
+        size_t p = b;
+        if ((p < e) && (expr[p] == '^')) {
+            negate = true;
+            ++p;
+        }
+        while (p < e) {
+            // === single character or escape ===
+            int lo = -1;  // character, if not a set escape (\s etc.)
+            if (expr[p] == '\\') {
+                const charClass_t esc = parseEscape(p + 1);
+                p += 2;
+                if (esc.count() == 1)
+                    lo = esc.first();
+                else
+                    set |= esc;
+            } else {
+                lo = (unsigned char)expr[p++];
+            }
+            if (lo < 0) continue;
+
+            // === range lo-hi ===
+            if ((p + 1 < e) && (expr[p] == '-')) {
+                ++p;
+                int hi = (unsigned char)expr[p];
+                if (expr[p] == '\\') {
+                    const charClass_t esc = parseEscape(p + 1);
+                    if (esc.count() != 1) fail("invalid range in character class", p);
+                    hi = esc.first();
+                    ++p;
+                }
+                ++p;
+                if (hi < lo) fail("invalid range in character class", p);
+                for (int ch = lo; ch <= hi; ++ch)
+                    set.set(ch);
+            } else {
+                set.set(lo);
+            }
+        }
+        if (negate) set.flip();
+        return set;
+    }
+
+    // character escape at pos (after '\')
+    constexpr charClass_t parseEscape(size_t pos) const {
+        const char c = expr[pos];
+        charClass_t set;
+        switch (c) {
+            case 's':
+            case 'S':
+                set.set(' ');
+                set.set('\t');
+                set.set('\n');
+                set.set('\v');
+                set.set('\f');
+                set.set('\r');
+                break;
+            case 'd':
+            case 'D':
+                for (int ch = '0'; ch <= '9'; ++ch)
+                    set.set(ch);
+                break;
+            case 'w':
+            case 'W':
+                for (int ch = 0; ch < 128; ++ch)
+                    if (isAlnum(ch) || (ch == '_')) set.set(ch);
+                break;
+            case 'n':
+                set.set('\n');
+                return set;
+            case 'r':
+                set.set('\r');
+                return set;
+            case 't':
+                set.set('\t');
+                return set;
+            case 'f':
+                set.set('\f');
+                return set;
+            case 'v':
+                set.set('\v');
+                return set;
+            default:
+                if (isAlnum(c)) fail("unsupported escape", pos - 1);
+                // escaped metacharacter
+                set.set((unsigned char)c);
+                return set;
+        }
+        if ((c == 'S') || (c == 'D') || (c == 'W')) set.flip();
+        return set;
+    }
+
+    const char* expr;
+    size_t len;
+    store_t& out;
+};
+
+// VM program compiled at build time from a constant expression, see myRegexCt. MAXINST / MAXCLASS bound its size
+template <size_t MAXINST, size_t MAXCLASS>
+class myRegexNfaCt {
+   public:
+    constexpr myRegexNfaCt(const char* expr, size_t len) : prog{}, nInst(0), classes{}, nClasses(0), nGroups(0) {
+        myRegexNfaCompiler<myRegexNfaCt> c(expr, len, *this);
+        c.compile();
+    }
+
+    // program for myRegexNfa (refers to this object)
+    constexpr myRegexNfa::program_t getProgram() const { return myRegexNfa::program_t{prog.data(), nInst, classes.data(), nGroups}; }
+
+    // === store_t interface for myRegexNfaCompiler ===
+    constexpr uint32_t append(myRegexNfa::op_e op, uint32_t x, uint32_t y) {
+        if (nInst == MAXINST) throw std::runtime_error("myRegexNfaCt: program too large");
+        prog[nInst] = myRegexNfa::inst_t{op, x, y};
+        return nInst++;
+    }
+    constexpr myRegexNfa::inst_t& at(uint32_t ix) { return prog[ix]; }
+    constexpr size_t size() const { return nInst; }
+    constexpr uint32_t addClass(const myRegexNfa::charClass_t& c) {
+        if (nClasses == MAXCLASS) throw std::runtime_error("myRegexNfaCt: too many character classes");
+        classes[nClasses] = c;
+        return nClasses++;
+    }
+    constexpr void setNGroups(size_t n) { nGroups = n; }
+
+   private:
+    std::array<myRegexNfa::inst_t, MAXINST> prog;
+    size_t nInst;
+    std::array<myRegexNfa::charClass_t, MAXCLASS> classes;
+    size_t nClasses;
+    size_t nGroups;
+};
@@ -1,51 +1,181 @@
 #include "myRegexRange.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>  // UINT32_MAX
+#include <cstring>  // memchr, memcmp
 #include <iterator>
 #include <map>
+#include <mutex>
+#include <type_traits>
 
+#include "lineIndex.h"
 #include "myRegexBase.h"
+#include "myRegexNfa.h"
+#include "regexRegistry.h"
 
 using std::string, std::map, std::to_string, std::runtime_error, std::vector, std::smatch, std::ssub_match, std::pair;
+static_assert(std::is_trivially_copyable<myRegexRange>::value, "myRegexRange is meant to be copied as plain data");
+
+// contents and filename of all root-level myRegexRange objects, by fileId. Lookup is lock-free: entries don't move (allocated in chunks) and
+// a fileId reaches other threads only through synchronization (e.g. workerPool) after the entry was written.
+// A fileId holds the entry index and, in its upper bits, the entry's generation: released entries are reused under a new generation
+class myRegexRangeFileTable {
+   public:
+    typedef struct {
+        std::shared_ptr<const char> body;
+        size_t size;
+        std::string filename;
+        // built on first use by regionInSource
+        std::shared_ptr<const lineIndex> lines;
+        // incremented on release (modulo 1 << GENERATIONBITS)
+        uint32_t generation = 0;
+    } entry_t;
+    myRegexRangeFileTable() : chunks(), mtx(), nIds(0), freeIds() {}
+    ~myRegexRangeFileTable() {
+        for (auto& c : chunks)
+            delete[] c.load();
+    }
+    uint32_t add(const std::shared_ptr<const char>& body, size_t size, const std::string& filename) {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint32_t ix;
+        if (freeIds.size() > 0) {
+            ix = freeIds.back();
+            freeIds.pop_back();
+        } else {
+            if (nIds == NCHUNKS * CHUNKSIZE) throw runtime_error("myRegexRange: too many files");
+            ix = nIds++;
+            if (ix % CHUNKSIZE == 0) chunks[ix / CHUNKSIZE].store(new entry_t[CHUNKSIZE], std::memory_order_release);
+        }
+        entry_t& e = entry(ix);
+        e.body = body;
+        e.size = size;
+        e.filename = filename;
+        return (e.generation << INDEXBITS) | ix;
+    }
+    void release(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!isLive(id)) throw runtime_error("myRegexRange: file released twice");
+        entry_t& e = at(id);
+        e.body.reset();
+        e.filename.clear();
+        e.lines.reset();
+        e.generation = (e.generation + 1) % (1u << GENERATIONBITS);
+        freeIds.push_back(id & INDEXMASK);
+    }
+    // line index of the file, built on first use. Concurrent first calls may build it more than once, one result is kept
+    std::shared_ptr<const lineIndex> lines(uint32_t id) {
+        entry_t& e = at(id);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (e.lines) return e.lines;
+        }
+        auto li = std::make_shared<const lineIndex>(e.body.get(), e.body.get() + e.size);
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!e.lines) e.lines = li;
+        return e.lines;
+    }
+    entry_t& at(uint32_t id) const {
+        assert(isLive(id) && "myRegexRange used after its file was released");
+        return entry(id & INDEXMASK);
+    }
+    // false if the file of id was released (the entry may be in use for another file)
+    bool isLive(uint32_t id) const {
+        const uint32_t ix = id & INDEXMASK;
+        if (ix >= nIds) return false;
+        const entry_t& e = entry(ix);
+        return (e.generation == (id >> INDEXBITS)) && e.body;
+    }
+
+   private:
+    entry_t& entry(uint32_t ix) const { return chunks[ix / CHUNKSIZE].load(std::memory_order_acquire)[ix % CHUNKSIZE]; }
+    static constexpr size_t CHUNKSIZE = 1024;
+    static constexpr size_t NCHUNKS = 4096;
+    // NCHUNKS * CHUNKSIZE entries
+    static constexpr uint32_t INDEXBITS = 22;
+    static constexpr uint32_t INDEXMASK = (1u << INDEXBITS) - 1;
+    static constexpr uint32_t GENERATIONBITS = 32 - INDEXBITS;
+    static_assert(NCHUNKS * CHUNKSIZE == (size_t(1) << INDEXBITS), "fileId layout");
+    std::atomic<entry_t*> chunks[NCHUNKS];
+    std::mutex mtx;
+    std::atomic<uint32_t> nIds;
+    std::vector<uint32_t> freeIds;
+};
+
+static myRegexRangeFileTable& fileTable() {
+    static myRegexRangeFileTable t;
+    return t;
+}
+
 // ==========================
 // === myRegexRange API
 // ==========================
 
-MHPP("public")
-// creates root-level object with copy of the original text, managing ownership with substrings (shared_ptr internally)
-myRegexRange::myRegexRange(const std::string& text, const std::string& filename)
-    : body(std::make_shared<string>(text.cbegin(), text.cend())),
-      filename(filename),
-      iBegin(body->cbegin()),
-      iEnd(body->cend()) {}
+MHPP("public static")
+// creates root-level object taking over the original text (no copy). Substrings are valid as long as the handle
+myRegexRange::root_t myRegexRange::own(std::string&& text, const std::string& filename) {
+    return ownRoot(myRegexRange(std::make_shared<string>(std::move(text)), filename));
+}
+
+MHPP("public static")
+// creates root-level object on a read-only memory mapping of the file (no copy), unmapped with the handle. The file may be replaced (renamed over) but not truncated while mapped
+myRegexRange::root_t myRegexRange::mapFile(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("failed to open '" + filename + "'");
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw runtime_error("failed to stat '" + filename + "'");
+    }
+    const size_t size = st.st_size;
+    if (size == 0) {
+        // zero-length mappings are not allowed
+        ::close(fd);
+        return own(string(), filename);
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // mapping stays valid
+    if (p == MAP_FAILED) throw runtime_error("failed to map '" + filename + "'");
+    std::shared_ptr<const char> body(static_cast<const char*>(p), [size](const char* p) { ::munmap(const_cast<char*>(p), size); });
+    return ownRoot(myRegexRange(body, size, filename));
+}
 
 MHPP("public")
 // copies contained (sub)string into new string
-std::string myRegexRange::str() const { return string(iBegin, iEnd); }
+std::string myRegexRange::str() const { return string(begin(), end()); }
 
 MHPP("public")
-std::string::const_iterator myRegexRange::begin() const { return iBegin; }
+const char* myRegexRange::begin() const { return fileTable().at(fileId).body.get() + offBegin; }
 
 MHPP("public")
-std::string::const_iterator myRegexRange::end() const { return iEnd; }
+const char* myRegexRange::end() const { return fileTable().at(fileId).body.get() + offEnd; }
 
 MHPP("public")
 // new myRegexRange with substring of source, using iBegin and iEnd from a regex match
-myRegexRange myRegexRange::substr(const std::string::const_iterator iBegin, const std::string::const_iterator iEnd) const {
-    assert((this->iEnd >= this->iBegin) && "this is reversed");
+myRegexRange myRegexRange::substr(const char* iBegin, const char* iEnd) const {
+    const char* base = fileTable().at(fileId).body.get();
+    assert((offEnd >= offBegin) && "this is reversed");
     assert((iEnd >= iBegin) && "arg is reversed");
-    assert((iBegin >= this->iBegin) && "iBegin below string");
-    assert((iBegin <= this->iEnd) && "iBegin above string");
-    assert((iEnd >= this->iBegin) && "iEnd below string");
-    assert((iEnd <= this->iEnd) && "iEnd above string");
-    return myRegexRange(*this, iBegin, iEnd);
+    assert((iBegin >= base + offBegin) && "iBegin below string");
+    assert((iBegin <= base + offEnd) && "iBegin above string");
+    assert((iEnd >= base + offBegin) && "iEnd below string");
+    assert((iEnd <= base + offEnd) && "iEnd above string");
+    return myRegexRange(fileId, iBegin - base, iEnd - base);
 }
 
 MHPP("public")
 // applies std::regex_match and returns captures by position as myRegexRange. Failure to match returns false.
 bool myRegexRange::match(const std::regex& rx, std::vector<myRegexRange>& captures) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
     assert(captures.size() == 0);
-    std::smatch m;
+    std::cmatch m;
     if (!std::regex_match(iBegin, iEnd, m, rx))
         return false;
     for (const auto& it : m)
@@ -53,40 +183,86 @@ bool myRegexRange::match(const std::regex& rx, std::vector<myRegexRange>& captur
     return true;
 }
 
+MHPP("public")
+// applies myRegexNfa::match and returns captures by position as myRegexRange. Failure to match returns false.
+bool myRegexRange::match(const myRegexNfa& rx, std::vector<myRegexRange>& captures) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
+    assert(captures.size() == 0);
+    vector<const char*> slots;
+    if (!rx.match(iBegin, iEnd, slots))
+        return false;
+    for (size_t ix = 0; ix < rx.getNGroups(); ++ix)
+        captures.push_back(substr(slots[2 * ix], slots[2 * ix + 1]));
+    return true;
+}
+
+MHPP("public")
+// applies regex_match with the engine selected by myRegexBase::setEngine and returns captures by position (see myRegexBase::captureIndex). Failure to match returns false.
+bool myRegexRange::match(const myRegexBase& rx, std::vector<myRegexRange>& captures) const {
+    if (myRegexBase::getEngine() == myRegexBase::ENGINE_NFA)
+        return match(regexRegistry::getNfa(rx.getExpr()), captures);
+    return match(rx.getRegex(), captures);
+}
+
 MHPP("public")
 // applies std::regex_match and returns captures by name from list as myRegexRange. Failure to match returns false.
 bool myRegexRange::match(const std::regex& rx, const std::vector<std::string>& names, std::map<std::string, myRegexRange>& captures) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
     assert(captures.size() == 0);
-    std::smatch m;
+    std::cmatch m;
     if (!std::regex_match(iBegin, iEnd, m, rx))
         return false;
     const size_t nCaptFromRegex = m.size();  // including "all" at pos 0
     assert(nCaptFromRegex == names.size() + 1);
     for (size_t ix = 0; ix < nCaptFromRegex; ++ix) {
         const string name = (ix == 0) ? string("all") : names[ix - 1];
-        auto r = captures.insert({name, substr(m[ix].first, m[ix].second)});
+        [[maybe_unused]] auto r = captures.insert({name, substr(m[ix].first, m[ix].second)});
+        assert(r.second && "named match insertion failed. Duplicate name?");
+    }
+    return true;
+}
+
+MHPP("public")
+// applies myRegexNfa::match and returns captures by name from list as myRegexRange. Failure to match returns false.
+bool myRegexRange::match(const myRegexNfa& rx, const std::vector<std::string>& names, std::map<std::string, myRegexRange>& captures) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
+    assert(captures.size() == 0);
+    vector<const char*> slots;
+    if (!rx.match(iBegin, iEnd, slots))
+        return false;
+    assert(rx.getNGroups() == names.size() + 1);
+    for (size_t ix = 0; ix < rx.getNGroups(); ++ix) {
+        const string name = (ix == 0) ? string("all") : names[ix - 1];
+        [[maybe_unused]] auto r = captures.insert({name, substr(slots[2 * ix], slots[2 * ix + 1])});
         assert(r.second && "named match insertion failed. Duplicate name?");
     }
     return true;
 }
 
 MHPP("public")
-// applies std::regex_match and returns captures by name as myRegexRange. Failure to match returns false.
+// applies regex_match with the engine selected by myRegexBase::setEngine and returns captures by name as myRegexRange. Failure to match returns false.
 bool myRegexRange::match(const myRegexBase& rx, std::map<std::string, myRegexRange>& captures) const {
-    return match((std::regex)rx, rx.getNames(), captures);
+    if (myRegexBase::getEngine() == myRegexBase::ENGINE_NFA)
+        return match(regexRegistry::getNfa(rx.getExpr()), rx.getNames(), captures);
+    return match(rx.getRegex(), rx.getNames(), captures);
 }
 
 MHPP("public")
 // split into unmatched|match|unmatched|match|...|unmatched, returns matches (size n) with submatch lists and unmatched(size n+1)
 void myRegexRange::splitByMatches(const std::regex& rx, std::vector<myRegexRange>& nonMatch, std::vector<std::vector<myRegexRange>>& captures) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
     assert(0 == nonMatch.size());
     assert(0 == captures.size());
-    std::sregex_iterator it(iBegin, iEnd, rx);
+    std::cregex_iterator it(iBegin, iEnd, rx);
     // cout << "got iterator " << endl; // this part can be slow
-    const std::sregex_iterator itEnd;
+    const std::cregex_iterator itEnd;
     auto cursor = iBegin;
     while (it != itEnd) {
-        const smatch& oneMatch = *it;
+        const std::cmatch& oneMatch = *it;
 
         // uncaptured region up to beginning of match
         nonMatch.push_back(substr(cursor, oneMatch[0].first));
@@ -105,76 +281,187 @@ void myRegexRange::splitByMatches(const std::regex& rx, std::vector<myRegexRange
     // cout << "iterator done " << endl;
 }
 
+// finds the next occurrence of any of a set of literals. Searches for the first character with memchr, remembers each literal's next occurrence
+class anchorFinder {
+   public:
+    anchorFinder(const std::vector<std::string>& anchors, const char* end) : anchors(anchors), end(end), nextByAnchor(anchors.size(), nullptr) {}
+    // first position at or after from where one of the anchors starts, end if none
+    const char* find(const char* from) {
+        const char* r = end;
+        for (size_t ix = 0; ix < anchors.size(); ++ix) {
+            if ((nextByAnchor[ix] == nullptr) || (nextByAnchor[ix] < from))
+                nextByAnchor[ix] = search(anchors[ix], from);
+            r = std::min(r, nextByAnchor[ix]);
+        }
+        return r;
+    }
+
+   private:
+    const char* search(const std::string& anchor, const char* p) const {
+        while ((size_t)(end - p) >= anchor.size()) {
+            p = (const char*)std::memchr(p, anchor[0], (end - p) - anchor.size() + 1);
+            if (p == nullptr) return end;
+            if (std::memcmp(p + 1, anchor.data() + 1, anchor.size() - 1) == 0) return p;
+            ++p;
+        }
+        return end;
+    }
+    const std::vector<std::string>& anchors;
+    const char* end;
+    std::vector<const char*> nextByAnchor;
+};
+
 MHPP("public")
-// split into unmatched|match|unmatched|match|...|unmatched, returns matches with named submatches in map(size n) and unmatched(size n+1)
-void myRegexRange::splitByMatches(const std::regex& rx, const std::vector<std::string>& names, std::vector<myRegexRange>& nonMatch, std::vector<std::map<std::string, myRegexRange>>& captures) const {
-    assert(captures.size() == 0);
-    vector<vector<myRegexRange>> rawMatches;
-    splitByMatches(rx, nonMatch, rawMatches);
-
-    for (const auto& it : rawMatches) {
-        const vector<myRegexRange>& oneRawMatch = it;
-        assert(oneRawMatch.size() == names.size() + 1);
-        map<string, myRegexRange> rInner;
-        for (size_t ix = 0; ix < oneRawMatch.size(); ++ix) {
-            if (ix == 0) {
-                auto q = rInner.insert({"all", oneRawMatch[ix]});
-                assert(q.second);
-            } else {
-                auto q = rInner.insert({names[ix - 1], oneRawMatch[ix]});
-                assert(q.second);
+// calls visitor for each match, left to right as std::regex_iterator. Non-empty anchors: a match is attempted only where one of them starts.
+// Same result if every match of rx begins with an anchor. Cost then scales with the number of anchors found instead of the range size
+void myRegexRange::forEachMatch(const std::regex& rx, const std::vector<std::string>& anchors, const myRegexRange::matchVisitor_t& visitor) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
+    vector<myRegexRange> capt;
+    auto visit = [&](const std::cmatch& m) {
+        capt.clear();
+        for (const auto& sub : m)
+            capt.push_back(substr(sub.first, sub.second));
+        visitor(capt);
+    };
+    if (anchors.size() == 0) {
+        for (std::cregex_iterator it(iBegin, iEnd, rx), itEnd; it != itEnd; ++it)
+            visit(*it);
+        return;
+    }
+    anchorFinder finder(anchors, iEnd);
+    std::cmatch m;
+    for (const char* from = finder.find(iBegin); from != iEnd;) {
+        const auto flags = std::regex_constants::match_continuous | ((from == iBegin) ? std::regex_constants::match_default : std::regex_constants::match_prev_avail);
+        if (!std::regex_search(from, iEnd, m, rx, flags)) {
+            from = finder.find(from + 1);
+            continue;
+        }
+        visit(m);
+        from = finder.find((m[0].first == m[0].second) ? m[0].second + 1 : m[0].second);
+    }
+}
+
+MHPP("public")
+// forEachMatch using myRegexNfa
+void myRegexRange::forEachMatch(const myRegexNfa& rx, const std::vector<std::string>& anchors, const myRegexRange::matchVisitor_t& visitor) const {
+    const char* iBegin = begin();
+    const char* iEnd = end();
+    vector<myRegexRange> capt;
+    vector<const char*> slots;
+    anchorFinder finder(anchors, iEnd);
+    const char* from = (anchors.size() == 0) ? iBegin : finder.find(iBegin);
+    while (true) {
+        if (anchors.size() == 0) {
+            if (!rx.search(iBegin, iEnd, from, slots)) return;
+        } else {
+            if (from == iEnd) return;
+            if (!rx.matchAt(iBegin, iEnd, from, slots)) {
+                from = finder.find(from + 1);
+                continue;
             }
         }
-        captures.push_back(rInner);
+        capt.clear();
+        for (size_t ix = 0; ix < rx.getNGroups(); ++ix)
+            capt.push_back(substr(slots[2 * ix], slots[2 * ix + 1]));
+        visitor(capt);
+
+        // === continue behind the match (behind the next character after an empty match, as std::regex_iterator) ===
+        from = slots[1];
+        if (slots[0] == slots[1]) {
+            if (from == iEnd) return;
+            ++from;
+        }
+        if (anchors.size() > 0) from = finder.find(from);
     }
 }
 
 MHPP("public")
-// split into unmatched|match|unmatched|match|...|unmatched
-void myRegexRange::splitByMatches(const myRegexBase& rx, std::vector<myRegexRange>& nonMatch, std::vector<std::map<std::string, myRegexRange>>& captures) const {
-    const std::regex reg = (std::regex)rx;
-    const vector<string> names = rx.getNames();
-    splitByMatches(reg, names, nonMatch, captures);
+// forEachMatch (without anchors) with the engine selected by myRegexBase::setEngine
+void myRegexRange::forEachMatch(const myRegexBase& rx, const myRegexRange::matchVisitor_t& visitor) const {
+    if (myRegexBase::getEngine() == myRegexBase::ENGINE_NFA)
+        forEachMatch(regexRegistry::getNfa(rx.getExpr()), {}, visitor);
+    else
+        forEachMatch(rx.getRegex(), {}, visitor);
 }
 
 MHPP("public")
 // returns line-/character position of substring in source
 void myRegexRange::regionInSource(size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd, std::string& fname, bool base1) const {
-    fname = filename;
-    size_t lcount = 0;
-    size_t ccount = 0;
-    size_t offset = base1 ? 1 : 0;
-    std::string::const_iterator it = body->cbegin();
-    while (it != iBegin) {
-        if (*it == '\n') {
-            ++lcount;
-            ccount = 0;
-        } else {
-            ++ccount;
-        }
-        ++it;
+    fname = fileTable().at(fileId).filename;
+    fileTable().lines(fileId)->regionInSource(offBegin, offEnd, base1, lineBegin, charBegin, lineEnd, charEnd);
+}
+
+MHPP("private static")
+// takes over the contents of a newly created root-level object: they are freed with the handle
+myRegexRange::root_t myRegexRange::ownRoot(const myRegexRange& root) {
+    assert((root.offBegin == 0) && "expecting root-level object");
+    try {
+        return root_t(new myRegexRange(root));
+    } catch (...) {
+        release(root);
+        throw;
     }
-    lineBegin = lcount + offset;
-    charBegin = ccount + offset;
-    while (it != iEnd) {
-        if (*it == '\n') {
-            ++lcount;
-            ccount = 0;
-        } else {
-            ++ccount;
-        }
-        ++it;
+}
+
+MHPP("public")
+// false if the contents were released (see root_t). Any other use of the object is then an error
+bool myRegexRange::isLive() const { return fileTable().isLive(fileId); }
+
+MHPP("private static")
+// frees the contents of root's file. All myRegexRange objects on it become invalid (the file table entry is reused under a new generation)
+void myRegexRange::release(const myRegexRange& root) {
+    assert((root.offBegin == 0) && "expecting root-level object");
+    fileTable().release(root.fileId);
+}
+
+MHPP("public static")
+// checks ownership by root_t and detection of released files. Throws on failure
+void myRegexRange::testcases() {
+    auto fail = [](const string& what) { throw runtime_error("myRegexRange testcase failed: " + what); };
+    vector<myRegexRange> stale;
+    {
+        const root_t a = own(string("hello world"), "a");
+        stale.push_back(a->substr(a->begin() + 6, a->end()));
+        if (!stale[0].isLive() || (stale[0].str() != "world")) fail("substring");
     }
-    lineEnd = lcount + offset;
-    charEnd = ccount + offset;
+    if (stale[0].isLive()) fail("substring of a released file");
+
+    // === the released entry is reused for the next file, stale objects stay detectable ===
+    const root_t b = own(string("other"), "b");
+    if (!b->isLive() || (b->str() != "other")) fail("reused entry");
+    if (stale[0].isLive()) fail("substring of a released file, entry reused");
+
+    // === released when an exception unwinds the handle ===
+    try {
+        const root_t c = own(string("thrown"), "c");
+        stale.push_back(*c);
+        throw runtime_error("testcase");
+    } catch (runtime_error&) {
+    }
+    if (stale[1].isLive()) fail("release on exception");
 }
 
 // ==========================
 // === myRegexRange internal
 // ==========================
+// pointer to the characters of text, sharing ownership of text (aliasing constructor)
+static std::shared_ptr<const char> charsOf(const std::shared_ptr<const std::string>& text) { return std::shared_ptr<const char>(text, text->data()); }
+
+MHPP("private")
+// root-level object owning text
+myRegexRange::myRegexRange(const std::shared_ptr<const std::string> text, const std::string& filename)
+    : myRegexRange(charsOf(text), text->size(), filename) {}
+
+MHPP("private")
+// root-level object on externally owned memory (body ownership passes to the file table)
+myRegexRange::myRegexRange(std::shared_ptr<const char> body, size_t size, const std::string& filename)
+    : fileId(0), offBegin(0), offEnd(0) {
+    if (size > UINT32_MAX) throw runtime_error("'" + filename + "' is too large (4 GB limit)");
+    fileId = fileTable().add(body, size, filename);
+    offEnd = size;
+}
+
 MHPP("private")
-myRegexRange::myRegexRange(const myRegexRange& src, std::string::const_iterator iBegin, std::string::const_iterator iEnd)
-    : body(src.body),
-      filename(src.filename),
-      iBegin(iBegin),
-      iEnd(iEnd) {}
\ No newline at end of file
+myRegexRange::myRegexRange(uint32_t fileId, uint32_t offBegin, uint32_t offEnd)
+    : fileId(fileId), offBegin(offBegin), offEnd(offEnd) {}
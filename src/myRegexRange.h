@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -9,42 +11,77 @@
 #define MHPP(arg)  // see https://github.com/mnentwig/makeheaderspp
 #endif
 class myRegexBase;
+class myRegexNfa;
 // manage many substrings (regex results, tokenizer output etc) that need to be referenced to the original test e.g. for error messages
 class myRegexRange {
+   public:
+    // receives the captures of one match by capture number (0: whole match, see myRegexBase::captureIndex). The vector is reused between calls
+    typedef std::function<void(const std::vector<myRegexRange>& captures)> matchVisitor_t;
+    // releases the contents of a root-level object (see release), then deletes it
+    struct rootDeleter_t {
+        void operator()(const myRegexRange* root) const {
+            release(*root);
+            delete root;
+        }
+    };
+    // owns the contents of a root-level object: they are freed when the handle goes away, on every path (all substrings become invalid)
+    typedef std::unique_ptr<const myRegexRange, rootDeleter_t> root_t;
     MHPP("begin myRegexRange") // === autogenerated code. Do not edit ===
     public:
-    	// creates root-level object with copy of the original text, managing ownership with substrings (shared_ptr internally)
-    	myRegexRange(const std::string& text, const std::string& filename);
+    	// creates root-level object taking over the original text (no copy). Substrings are valid as long as the handle
+    	static myRegexRange::root_t own(std::string&& text, const std::string& filename);
+    	// creates root-level object on a read-only memory mapping of the file (no copy), unmapped with the handle. The file may be replaced (renamed over) but not truncated while mapped
+    	static myRegexRange::root_t mapFile(const std::string& filename);
     	// copies contained (sub)string into new string
     	std::string str() const;
-    	std::string::const_iterator begin() const;
-    	std::string::const_iterator end() const;
+    	const char* begin() const;
+    	const char* end() const;
     	// new myRegexRange with substring of source, using iBegin and iEnd from a regex match
-    	myRegexRange substr(const std::string::const_iterator iBegin, const std::string::const_iterator iEnd) const;
+    	myRegexRange substr(const char* iBegin, const char* iEnd) const;
     	// applies std::regex_match and returns captures by position as myRegexRange. Failure to match returns false.
     	bool match(const std::regex& rx, std::vector<myRegexRange>& captures) const;
+    	// applies myRegexNfa::match and returns captures by position as myRegexRange. Failure to match returns false.
+    	bool match(const myRegexNfa& rx, std::vector<myRegexRange>& captures) const;
+    	// applies regex_match with the engine selected by myRegexBase::setEngine and returns captures by position (see myRegexBase::captureIndex). Failure to match returns false.
+    	bool match(const myRegexBase& rx, std::vector<myRegexRange>& captures) const;
     	// applies std::regex_match and returns captures by name from list as myRegexRange. Failure to match returns false.
     	bool match(const std::regex& rx, const std::vector<std::string>& names, std::map<std::string, myRegexRange>& captures) const;
-    	// applies std::regex_match and returns captures by name as myRegexRange. Failure to match returns false.
+    	// applies myRegexNfa::match and returns captures by name from list as myRegexRange. Failure to match returns false.
+    	bool match(const myRegexNfa& rx, const std::vector<std::string>& names, std::map<std::string, myRegexRange>& captures) const;
+    	// applies regex_match with the engine selected by myRegexBase::setEngine and returns captures by name as myRegexRange. Failure to match returns false.
     	bool match(const myRegexBase& rx, std::map<std::string, myRegexRange>& captures) const;
     	// split into unmatched|match|unmatched|match|...|unmatched, returns matches (size n) with submatch lists and unmatched(size n+1)
     	void splitByMatches(const std::regex& rx, std::vector<myRegexRange>& nonMatch, std::vector<std::vector<myRegexRange>>& captures) const;
-    	// split into unmatched|match|unmatched|match|...|unmatched, returns matches with named submatches in map(size n) and unmatched(size n+1)
-    	void splitByMatches(const std::regex& rx, const std::vector<std::string>& names, std::vector<myRegexRange>& nonMatch, std::vector<std::map<std::string, myRegexRange>>& captures) const;
-    	// split into unmatched|match|unmatched|match|...|unmatched
-    	void splitByMatches(const myRegexBase& rx, std::vector<myRegexRange>& nonMatch, std::vector<std::map<std::string, myRegexRange>>& captures) const;
+    	// calls visitor for each match, left to right as std::regex_iterator. Non-empty anchors: a match is attempted only where one of them starts.
+    	// Same result if every match of rx begins with an anchor. Cost then scales with the number of anchors found instead of the range size
+    	void forEachMatch(const std::regex& rx, const std::vector<std::string>& anchors, const myRegexRange::matchVisitor_t& visitor) const;
+    	// forEachMatch using myRegexNfa
+    	void forEachMatch(const myRegexNfa& rx, const std::vector<std::string>& anchors, const myRegexRange::matchVisitor_t& visitor) const;
+    	// forEachMatch (without anchors) with the engine selected by myRegexBase::setEngine
+    	void forEachMatch(const myRegexBase& rx, const myRegexRange::matchVisitor_t& visitor) const;
     	// returns line-/character position of substring in source
     	void regionInSource(size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd, std::string& fname, bool base1) const;
+    	// false if the contents were released (see root_t). Any other use of the object is then an error
+    	bool isLive() const;
+    	// checks ownership by root_t and detection of released files. Throws on failure
+    	static void testcases();
     private:
-    	myRegexRange(const myRegexRange& src, std::string::const_iterator iBegin, std::string::const_iterator iEnd);
+    	// takes over the contents of a newly created root-level object: they are freed with the handle
+    	static myRegexRange::root_t ownRoot(const myRegexRange& root);
+    	// frees the contents of root's file. All myRegexRange objects on it become invalid (the file table entry is reused under a new generation)
+    	static void release(const myRegexRange& root);
+    	// root-level object owning text
+    	myRegexRange(const std::shared_ptr<const std::string> text, const std::string& filename);
+    	// root-level object on externally owned memory (body ownership passes to the file table)
+    	myRegexRange(std::shared_ptr<const char> body, size_t size, const std::string& filename);
+    	myRegexRange(uint32_t fileId, uint32_t offBegin, uint32_t offEnd);
     MHPP("end myRegexRange")
    private:
-    // original string e.g. source file contents, of which this represents a substring
-    std::shared_ptr<const std::string> body;
-    // filename where body was read from
-    const std::string filename;
-    // start of substring in body
-    std::string::const_iterator iBegin;
-    // end of substring in body
-    std::string::const_iterator iEnd;
-};
\ No newline at end of file
+    // file table entry (contents and filename, see myRegexRange.cpp) shared by the root-level object and all its substrings.
+    // Upper bits: generation of the entry, which changes when it is released (detects use of a released file)
+    uint32_t fileId;
+    // start of substring in the file contents
+    uint32_t offBegin;
+    // end of substring in the file contents
+    uint32_t offEnd;
+};
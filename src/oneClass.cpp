@@ -2,6 +2,8 @@
 
 #include <regex>
 #include <stdexcept>
+
+#include "regexRegistry.h"
 using std::string, std::vector, std::runtime_error;
 
 MHPP("public")
@@ -65,6 +67,12 @@ void oneClass::addTextByKeyword(const std::string& keyword, const std::vector<st
         privateText.insert(privateText.end(), text.cbegin(), text.cend());
 }
 
+MHPP("public")
+// true if both hold the same declarations
+bool oneClass::equals(const oneClass& arg) const {
+    return (publicText == arg.publicText) && (protectedText == arg.protectedText) && (privateText == arg.privateText) && (rawText == arg.rawText);
+}
+
 MHPP("public static")
 std::string oneClass::indentStringVec(const std::vector<std::string>& vec, const std::string& indent) {
     string r;
@@ -77,7 +85,7 @@ MHPP("protected static")
 // splits a string item containing newlines into multiple items with added indentation after the first one
 std::vector<std::string> oneClass::splitMultilineAndIndent(const std::vector<std::string>& arg) {
     vector<string> r;
-    const std::regex rsplit("\\r*\\n");
+    const std::regex& rsplit = regexRegistry::get("\\r*\\n");
     for (const string& line : arg) {
         std::sregex_token_iterator it(line.cbegin(),
                                       line.cend(),
@@ -99,7 +107,7 @@ MHPP("protected static")
 // splits a string item containing newlines into multiple items
 std::vector<std::string> oneClass::splitMultiline(const std::vector<std::string>& arg) {
     vector<string> r;
-    const std::regex rsplit("\\r*\\n");
+    const std::regex& rsplit = regexRegistry::get("\\r*\\n");
     for (const string& line : arg) {
         std::sregex_token_iterator it(line.cbegin(),
                                       line.cend(),
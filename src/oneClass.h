@@ -21,6 +21,8 @@ class oneClass {
     	void addRawText(const std::vector<std::string>& txt);
     	void addRawText(const std::string& txt);
     	void addTextByKeyword(const std::string& keyword, const std::vector<std::string>& txt, const std::string& errorObjName);
+    	// true if both hold the same declarations
+    	bool equals(const oneClass& arg) const;
     	static std::string indentStringVec(const std::vector<std::string>& vec, const std::string& indent);
     protected:
     	// splits a string item containing newlines into multiple items with added indentation after the first one
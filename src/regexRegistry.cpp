@@ -0,0 +1,59 @@
+#include "regexRegistry.h"
+
+#include <sstream>
+using std::string, std::map, std::pair, std::regex;
+
+MHPP("private static")
+// guards all registry state
+std::mutex regexRegistry::mtx;
+
+MHPP("private static")
+std::map<std::pair<std::string, std::regex::flag_type>, std::regex> regexRegistry::regexByKey;
+
+MHPP("private static")
+std::map<std::string, myRegexNfa> regexRegistry::nfaByExpr;
+
+MHPP("private static")
+// total time spent compiling
+std::chrono::steady_clock::duration regexRegistry::compileTime;
+
+MHPP("public static")
+// std::regex for expr (ECMAScript syntax)
+const std::regex& regexRegistry::get(const std::string& expr) {
+    return get(expr, regex::ECMAScript);
+}
+
+MHPP("public static")
+// std::regex for expr with flags
+const std::regex& regexRegistry::get(const std::string& expr, std::regex::flag_type flags) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const pair<string, regex::flag_type> key(expr, flags);
+    auto it = regexByKey.find(key);
+    if (it != regexByKey.end()) return it->second;
+    const auto t0 = std::chrono::steady_clock::now();
+    it = regexByKey.emplace(key, regex(expr, flags)).first;
+    compileTime += std::chrono::steady_clock::now() - t0;
+    return it->second;
+}
+
+MHPP("public static")
+// myRegexNfa for expr
+const myRegexNfa& regexRegistry::getNfa(const std::string& expr) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = nfaByExpr.find(expr);
+    if (it != nfaByExpr.end()) return it->second;
+    const auto t0 = std::chrono::steady_clock::now();
+    it = nfaByExpr.try_emplace(expr, expr).first;
+    compileTime += std::chrono::steady_clock::now() - t0;
+    return it->second;
+}
+
+MHPP("public static")
+// number of compiled patterns and time spent compiling them, as text
+std::string regexRegistry::report() {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ostringstream s;
+    s << "compiled " << regexByKey.size() << " std::regex and " << nfaByExpr.size() << " myRegexNfa patterns in "
+      << std::chrono::duration<double, std::milli>(compileTime).count() << " ms";
+    return s.str();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <utility>
+
+#include "myRegexNfa.h"
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// process-wide store of compiled patterns, keyed by expression (and flags). Each pattern is compiled once, on first use.
+// Returned references stay valid until the process ends. Safe to use from worker threads
+class regexRegistry {
+    MHPP("begin regexRegistry") // === autogenerated code. Do not edit ===
+    public:
+    	// std::regex for expr (ECMAScript syntax)
+    	static const std::regex& get(const std::string& expr);
+    	// std::regex for expr with flags
+    	static const std::regex& get(const std::string& expr, std::regex::flag_type flags);
+    	// myRegexNfa for expr
+    	static const myRegexNfa& getNfa(const std::string& expr);
+    	// number of compiled patterns and time spent compiling them, as text
+    	static std::string report();
+    private:
+    	// guards all registry state
+    	static std::mutex mtx;
+    	static std::map<std::pair<std::string, std::regex::flag_type>, std::regex> regexByKey;
+    	static std::map<std::string, myRegexNfa> nfaByExpr;
+    	// total time spent compiling
+    	static std::chrono::steady_clock::duration compileTime;
+    MHPP("end regexRegistry")
+};
@@ -1,26 +1,135 @@
 #include "regionized.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <iostream>  // debug
+#include <cstdint>
+#include <cstring>  // memchr, strlen
 #include <iterator>
 #include <memory>
 #include <tuple>
 #include <vector>
-using std::cout, std::endl;  // debug
 using std::runtime_error;
 using std::string, std::vector, std::tuple, std::shared_ptr;
 using std::to_string;
 
 MHPP("public")
-regionized::regionized(const csit_t begin, const csit_t end) : regions() {
-    auto it = begin;
-    it = cursor(it, it, end, /*level*/ 0, regions, /*tExit*/ "", TOPLEVEL);
-    assert(it == end);
+regionized::regionized(const csit_t begin, const csit_t end) : regions(), nodes(), byBegin() {
+    cursorIterative(begin, end, regions);
 }
 
 MHPP("public")
-// returns all regions (overlapping, in order of parsing, insertion at end of region)
-std::vector<regionized::region> regionized::getRegions() const { return regions; }
+// returns all regions (overlapping, in order of parsing, insertion at end of region). Valid as long as this object
+const std::vector<regionized::region>& regionized::getRegions() const { return regions; }
+
+MHPP("public")
+// calls visitor for each region of type rType (rType_e::INVALID selects all) in order of parsing, as getRegions()
+void regionized::forEachRegion(regionized::rType_e rType, const regionized::regionVisitor_t& visitor) const {
+    for (const region& r : regions)
+        if ((rType == INVALID) || (r.getRType() == rType))
+            visitor(r);
+}
+
+MHPP("public")
+// region by index into getRegions()
+const regionized::region& regionized::getRegion(size_t ixRegion) const {
+    assert(ixRegion < regions.size());
+    return regions[ixRegion];
+}
+
+MHPP("public")
+// number of regions, including TOPLEVEL
+size_t regionized::getNRegions() const { return regions.size(); }
+
+MHPP("public")
+// index of the TOPLEVEL region, which contains all others
+size_t regionized::getRoot() const { return regions.size() - 1; }
+
+MHPP("public")
+// enclosing region (NONE for the root)
+size_t regionized::getParent(size_t ixRegion) const {
+    buildTree();
+    return nodes[ixRegion].parent;
+}
+
+MHPP("public")
+// first directly nested region in text order (NONE if none)
+size_t regionized::getFirstChild(size_t ixRegion) const {
+    buildTree();
+    return nodes[ixRegion].firstChild;
+}
+
+MHPP("public")
+// next region with the same parent in text order (NONE if none)
+size_t regionized::getNextSibling(size_t ixRegion) const {
+    buildTree();
+    return nodes[ixRegion].nextSibling;
+}
+
+MHPP("public")
+// region of type rType starting at it (rType_e::INVALID selects all, then the outermost). NONE if none. Binary search
+size_t regionized::regionStartingAt(csit_t it, regionized::rType_e rType) const {
+    buildTree();
+    auto itB = std::lower_bound(byBegin.cbegin(), byBegin.cend(), it, [this](size_t ix, csit_t pos) { return regions[ix].getBegin() < pos; });
+    // (regions starting at the same position are nested: few)
+    for (; (itB != byBegin.cend()) && regions[*itB].startsAt(it); ++itB)
+        if ((rType == INVALID) || (regions[*itB].getRType() == rType))
+            return *itB;
+    return NONE;
+}
+
+MHPP("public")
+// directly nested regions of type rType (rType_e::INVALID selects all) in text order
+std::vector<size_t> regionized::children(size_t ixRegion, regionized::rType_e rType) const {
+    buildTree();
+    vector<size_t> r;
+    for (size_t ix = nodes[ixRegion].firstChild; ix != NONE; ix = nodes[ix].nextSibling)
+        if ((rType == INVALID) || (regions[ix].getRType() == rType))
+            r.push_back(ix);
+    return r;
+}
+
+MHPP("public")
+// all regions nested at any depth in ixRegion, of type rType (rType_e::INVALID selects all) in text order. Cost is the size of the subtree
+std::vector<size_t> regionized::descendants(size_t ixRegion, regionized::rType_e rType) const {
+    buildTree();
+    vector<size_t> r;
+    for (size_t ix = nodes[ixRegion].firstChild; ix != NONE; ix = nextInSubtree(ix, ixRegion))
+        if ((rType == INVALID) || (regions[ix].getRType() == rType))
+            r.push_back(ix);
+    return r;
+}
+
+MHPP("public")
+// calls visitor for the regions descendants() returns, without collecting them
+void regionized::forEachDescendant(size_t ixRegion, regionized::rType_e rType, const regionized::regionVisitor_t& visitor) const {
+    buildTree();
+    for (size_t ix = nodes[ixRegion].firstChild; ix != NONE; ix = nextInSubtree(ix, ixRegion))
+        if ((rType == INVALID) || (regions[ix].getRType() == rType))
+            visitor(regions[ix]);
+}
+
+MHPP("private")
+// region following ix in a pre-order walk of the subtree of ixRegion (NONE at its end)
+size_t regionized::nextInSubtree(size_t ix, size_t ixRegion) const {
+    if (nodes[ix].firstChild != NONE) return nodes[ix].firstChild;
+    while ((ix != ixRegion) && (nodes[ix].nextSibling == NONE))
+        ix = nodes[ix].parent;
+    return (ix == ixRegion) ? NONE : nodes[ix].nextSibling;
+}
+
+MHPP("public")
+// deepest region with it in [begin, end) (NONE if none). Binary search, then up the tree through regions ending before it
+size_t regionized::innermostContaining(csit_t it) const {
+    buildTree();
+    auto itB = std::upper_bound(byBegin.cbegin(), byBegin.cend(), it, [this](csit_t pos, size_t ix) { return pos < regions[ix].getBegin(); });
+    if (itB == byBegin.cbegin()) return NONE;
+    // last region starting at or before it. The innermost containing region is this one or an ancestor
+    size_t ix = *(itB - 1);
+    while ((ix != NONE) && (regions[ix].getEnd() <= it))
+        ix = nodes[ix].parent;
+    return ix;
+}
 
 MHPP("public")
 regionized::region::region() : begin(nullptr), end(nullptr), level(0), rType(regionized::rType_e::INVALID) {}
@@ -44,20 +153,53 @@ MHPP("public")
 bool regionized::region::contains(const regionized::region& arg) const { return (arg.begin >= begin) && (arg.end <= end); }
 
 MHPP("private")
-bool regionized::tokenFoundAtIt(const csit_t begin, const csit_t end, const std::string token) {
-    csit_t itText = begin;
-    csit_t itToken = token.cbegin();
-    while (itToken != token.cend()) {
-        if (itText == end) return false;
-        if (*(itText++) != *(itToken++)) return false;
+// links regions into the tree (on first use), from their levels in parsing order (a region closes after all its subregions)
+void regionized::buildTree() const {
+    if (nodes.size() > 0) return;
+    nodes.assign(regions.size(), node_t{NONE, NONE, NONE});
+    // === regions without parent yet. A closing region adopts those one level deeper at the top ===
+    vector<size_t> pending;
+    for (size_t ix = 0; ix < regions.size(); ++ix) {
+        const size_t level = regions[ix].getLevel();
+        size_t next = NONE;  // children are popped in reverse text order
+        while ((pending.size() > 0) && (regions[pending.back()].getLevel() == level + 1)) {
+            const size_t child = pending.back();
+            pending.pop_back();
+            nodes[child].parent = ix;
+            nodes[child].nextSibling = next;
+            next = child;
+        }
+        nodes[ix].firstChild = next;
+        pending.push_back(ix);
+    }
+    assert((pending.size() == 1) && (pending[0] == getRoot()));
+
+    // === pre-order ===
+    byBegin.clear();
+    byBegin.reserve(regions.size());
+    size_t ix = getRoot();
+    while (ix != NONE) {
+        byBegin.push_back(ix);
+        if (nodes[ix].firstChild != NONE) {
+            ix = nodes[ix].firstChild;
+            continue;
+        }
+        while ((ix != NONE) && (nodes[ix].nextSibling == NONE))
+            ix = nodes[ix].parent;
+        if (ix != NONE) ix = nodes[ix].nextSibling;
     }
-    return true;
 }
 
-MHPP("private")
+MHPP("private static")
+bool regionized::tokenFoundAtIt(const csit_t begin, const csit_t end, const std::string& token) {
+    if (size_t(end - begin) < token.size()) return false;
+    return std::equal(token.cbegin(), token.cend(), begin);
+}
+
+MHPP("private static")
 std::string regionized::getRawStringTerminatorOrDoubleQuote(const csit_t start, const csit_t end) {
     csit_t it = start;
-    const string dchar = string(R"--(!"#%&'*+,-./0123456789:;=?ABCDEFGHIJKLMNOPQRSTUVWXYZ^_abcdefghijklmnopqrstuvwxyz|~$@`)--");
+    static const string dchar = string(R"--(!"#%&'*+,-./0123456789:;=?ABCDEFGHIJKLMNOPQRSTUVWXYZ^_abcdefghijklmnopqrstuvwxyz|~$@`)--");
     // skip u8R in u8R" (advance it to double quote)
     for (size_t ix = 0; ix < 3; ++ix) {
         if (*it == '\"') break;
@@ -78,103 +220,307 @@ fail:
     return "\"";
 }
 
-MHPP("private")
-csit_t regionized::cursor(csit_t begin, csit_t beginSearch, csit_t end, size_t level, std::vector<region>& result, const std::string tExit, rType_e rType) {
-    //    cout << "..." << tExit << endl;
-    //    cout << "cursor" << level << "'" << string(begin, end) << "' " << tExit << endl;
-    assert(beginSearch >= begin);
-    assert(beginSearch <= end);
-    bool noRecurse = (rType == DQUOTE) || (rType == SQUOTE) || (rType == REM_C) || (rType == REM_CPP);  // strings and comments are lowest hierarchy level
-
-    const vector<std::tuple<string, string, rType_e>>
-        bracketpairs({{"<", ">", BRK_ANG},
-                      {"(", ")", BRK_RND},
-                      {"[", "]", BRK_SQU},
-                      {"{", "}", BRK_CRL},
-                      {"/*", "*/", REM_CPP},
-                      {"//", "\n", REM_C},
-                      {"'", "'", SQUOTE},
-                      {"\"", "\"", DQUOTE},
-                      {"L\"", "\"", DQUOTE},
-                      {"u8\"", "\"", DQUOTE},
-                      {"u\"", "\"", DQUOTE},
-                      {"U\"", "\"", DQUOTE}});
-
-    const vector<string> rawTokens({"R\"", "LR\"", "u8R\"", "uR\"", "UR\""});
-
-    csit_t it = beginSearch;
-    size_t ntExit = tExit.size();
-    bool stringBackslashEscape = false;
-    while (true) {
-        assert(it <= end);
+// what may start at a character, for regionized::cursor()
+typedef enum : uint8_t {
+    LEX_PLAIN = 0,
+    // < (or << operator)
+    LEX_ANG,
+    LEX_RND,
+    LEX_SQU,
+    LEX_CRL,
+    // /* or //
+    LEX_SLASH,
+    LEX_SQUOTE,
+    LEX_DQUOTE,
+    // string literal prefix e.g. u8" or raw string LR"
+    LEX_PREFIX
+} lexClass_e;
 
-        if (it == end) {
-            result.push_back(regionized::region(begin, end, level, rType));
-            return it;
+static constexpr std::array<uint8_t, 256> makeLexTable() {
+    std::array<uint8_t, 256> t{};
+    t['<'] = LEX_ANG;
+    t['('] = LEX_RND;
+    t['['] = LEX_SQU;
+    t['{'] = LEX_CRL;
+    t['/'] = LEX_SLASH;
+    t['\''] = LEX_SQUOTE;
+    t['"'] = LEX_DQUOTE;
+    t['R'] = t['L'] = t['u'] = t['U'] = LEX_PREFIX;
+    return t;
+}
+// one lookup per character decides whether a token may start there
+static constexpr std::array<uint8_t, 256> lexTable = makeLexTable();
+
+// exit tokens of the regions cursor() enters (constructed once, referenced by frame_t)
+static const string noExit = "";
+static const string exitAng = ">";
+static const string exitRnd = ")";
+static const string exitSqu = "]";
+static const string exitCrl = "}";
+static const string exitRemCpp = "*/";
+static const string exitRemC = "\n";
+static const string exitSquote = "'";
+static const string exitDquote = "\"";
+
+// length of a string literal prefix at it, up to and including the double quote (0 if none). isRaw: raw string e.g. u8R"
+static size_t stringPrefixLength(csit_t it, csit_t end, bool& isRaw) {
+    // raw variants first, as the original token list
+    static const char* const prefixes[] = {"R\"", "LR\"", "u8R\"", "uR\"", "UR\"", "L\"", "u8\"", "u\"", "U\""};
+    for (const char* p : prefixes) {
+        const size_t n = std::strlen(p);
+        if ((size_t(end - it) >= n) && std::equal(p, p + n, it)) {
+            isRaw = (p[n - 2] == 'R');
+            return n;
         }
+    }
+    return 0;
+}
+
+MHPP("private static")
+// advances it within region f up to the end of text, f's exit token or a subregion.
+// STEP_ENTER: sub describes the subregion, it points behind its opening token. A raw string's exit token is stored in rawExit (raw strings contain no subregions, so one suffices)
+regionized::lexStep_e regionized::lexStep(const regionized::frame_t& f, csit_t& it, csit_t end, regionized::frame_t& sub, std::string& rawExit) {
+    const rType_e rType = f.rType;
+    const std::string& tExit = *f.tExit;
+    const bool noRecurse = (rType == DQUOTE) || (rType == SQUOTE) || (rType == REM_C) || (rType == REM_CPP);  // strings and comments are lowest hierarchy level
+    // backslash escapes the next character (disabled in raw mode)
+    const bool backslashEscapes = (rType == SQUOTE) || ((rType == DQUOTE) && (tExit.size() == 1));
+    const char exitFirst = tExit.empty() ? 0 : tExit[0];  // empty tExit flags toplevel: run to end of string
+    auto enter = [&](size_t nOpen, const std::string* subExit, rType_e subType) {
+        sub = frame_t{it, it + nOpen, f.level + 1, subExit, subType};
+        it += nOpen;
+        return STEP_ENTER;
+    };
+
+    while (true) {
+        // === skip characters that can neither end the region nor start a token ===
+        if (noRecurse && !backslashEscapes) {
+            // comments and raw strings: memchr to the next candidate exit
+            if (it != end) {
+                const char* p = &*it;
+                const char* pExit = static_cast<const char*>(std::memchr(p, exitFirst, end - it));
+                it = (pExit == nullptr) ? end : it + (pExit - p);
+            }
+        } else if (noRecurse) {
+            while ((it != end) && (*it != exitFirst) && (*it != '\\'))
+                ++it;
+        } else {
+            while ((it != end) && (*it != exitFirst) && (lexTable[(unsigned char)*it] == LEX_PLAIN))
+                ++it;
+        }
+
+        assert(it <= end);
+        if (it == end) return STEP_END;
+        const char c = *it;
 
         // backslash-escaped character: Skipping the next char for end detection
-        if (stringBackslashEscape) {
-            stringBackslashEscape = false;
-            ++it;
-            goto continueMainLoop;
+        if (backslashEscapes && (c == '\\')) {
+            it += (end - it >= 2) ? 2 : 1;
+            continue;
         }
 
-        // backslash-escaped next character (disabled in raw mode)
-        if (*it == '\\' && ((rType == SQUOTE) || ((rType == DQUOTE) && (tExit.size() == 1)))) {
-            stringBackslashEscape = true;
+        // check for exit token
+        if ((exitFirst != 0) && (c == exitFirst) && tokenFoundAtIt(it, end, tExit)) return STEP_EXIT;
+
+        if (noRecurse) {
             ++it;
-            goto continueMainLoop;
+            continue;
         }
 
-        // check for exit token
-        if (ntExit > 0)                            // empty tExit flags toplevel: run to end of string
-            if (tokenFoundAtIt(it, end, tExit)) {  // exit token at it
-                if (rType == DQUOTE)
-                    result.push_back(regionized::region({beginSearch, it, level + 1, DQUOTE_BODY}));
-
-                it += tExit.size();  // include exit token in extracted region
-                // a C-style comment is terminated by \n or \r\n, identified by \n as last char in tExit.
-                // Move back to leave \n or \r\n as unprocessed text for caller.
-                if (tExit.back() == '\n') {
-                    --it;
-                    if ((it > beginSearch) && (*(it - 1) == '\r'))
-                        --it;
+        // === hierarchic subexpressions ===
+        const char next = (end - it >= 2) ? it[1] : 0;
+        switch (lexTable[(unsigned char)c]) {
+            case LEX_PLAIN:
+                ++it;
+                break;
+            case LEX_ANG:
+                // Skip << operator e.g. "cout << endl" to disambiguate from template angle brackets (which can open only one at a time)
+                if (next != '<') return enter(1, &exitAng, BRK_ANG);
+                it += 2;
+                break;
+            case LEX_RND:
+                return enter(1, &exitRnd, BRK_RND);
+            case LEX_SQU:
+                return enter(1, &exitSqu, BRK_SQU);
+            case LEX_CRL:
+                return enter(1, &exitCrl, BRK_CRL);
+            case LEX_SLASH:
+                if (next == '*') return enter(2, &exitRemCpp, REM_CPP);
+                if (next == '/') return enter(2, &exitRemC, REM_C);
+                ++it;
+                break;
+            case LEX_SQUOTE:
+                return enter(1, &exitSquote, SQUOTE);
+            case LEX_DQUOTE:
+                return enter(1, &exitDquote, DQUOTE);
+            case LEX_PREFIX: {
+                // mostly identifier characters: all prefixes continue with one of these
+                if ((next != '"') && (next != 'R') && (next != '8')) {
+                    ++it;
+                    break;
                 }
-                assert(it <= end);
-                result.push_back(regionized::region({begin, it, level, rType}));
-                return it;
+                bool isRaw = false;
+                const size_t n = stringPrefixLength(it, end, isRaw);
+                if (n == 0) {
+                    ++it;
+                    break;
+                }
+                if (!isRaw) return enter(n, &exitDquote, DQUOTE);
+                rawExit = getRawStringTerminatorOrDoubleQuote(it, end);
+                return enter(n, &rawExit, DQUOTE);
             }
+        }
+    }
+}
 
-        if (noRecurse)
-            goto skipRecursion;
+MHPP("private static")
+// closes region f at its exit token (at it). Returns the position behind the region
+csit_t regionized::exitRegion(const regionized::frame_t& f, csit_t it, std::vector<region>& result) {
+    if (f.rType == DQUOTE)
+        result.push_back(regionized::region({f.beginSearch, it, f.level + 1, DQUOTE_BODY}));
 
-        // Skip << operator e.g. "cout << endl" to disambiguate from template angle brackets (which can open only one at a time)
-        if (tokenFoundAtIt(it, end, string("<<"))) {
-            it += 2;
-            goto continueMainLoop;
+    const std::string& tExit = *f.tExit;
+    it += tExit.size();  // include exit token in extracted region
+    // a C-style comment is terminated by \n or \r\n, identified by \n as last char in tExit.
+    // Move back to leave \n or \r\n as unprocessed text for caller.
+    if (tExit.back() == '\n') {
+        --it;
+        if ((it > f.beginSearch) && (*(it - 1) == '\r'))
+            --it;
+    }
+    result.push_back(regionized::region({f.begin, it, f.level, f.rType}));
+    return it;
+}
+
+MHPP("private static")
+// parses region f from f.beginSearch up to its exit token (or end) into result, recursing into subregions. Returns the position behind the region
+csit_t regionized::cursor(const regionized::frame_t& f, csit_t end, std::vector<region>& result, std::string& rawExit) {
+    assert(f.beginSearch >= f.begin);
+    assert(f.beginSearch <= end);
+    csit_t it = f.beginSearch;
+    while (true) {
+        frame_t sub;
+        switch (lexStep(f, it, end, sub, rawExit)) {
+            case STEP_END:
+                result.push_back(regionized::region(f.begin, end, f.level, f.rType));
+                return end;
+            case STEP_EXIT:
+                return exitRegion(f, it, result);
+            case STEP_ENTER:
+                it = cursor(sub, end, result, rawExit);
+                break;
         }
+    }
+}
 
-        // search for raw string
-        for (const string& rawToken : rawTokens) {
-            if (tokenFoundAtIt(it, end, rawToken)) {
-                const string rawTerm = getRawStringTerminatorOrDoubleQuote(it, end);
-                cout << "XXXXXX rawTerm:" << rawTerm << endl;
-                it = cursor(it, it + rawToken.size(), end, level + 1, result, rawTerm, DQUOTE);
-                goto continueMainLoop;
-            }
+MHPP("private static")
+// same result as cursor() on the toplevel region, without recursion: open regions are kept on an explicit stack.
+// Nesting depth is limited only by memory
+void regionized::cursorIterative(csit_t begin, csit_t end, std::vector<region>& result) {
+    // (local: a deep parse would otherwise keep its peak stack allocated for the life of the thread)
+    vector<frame_t> stack;
+    string rawExit;
+    stack.push_back(frame_t{begin, begin, /*level*/ 0, &noExit, TOPLEVEL});
+    csit_t it = begin;
+    while (true) {
+        frame_t sub;
+        switch (lexStep(stack.back(), it, end, sub, rawExit)) {
+            case STEP_END:
+                // all open regions end here, innermost first
+                while (stack.size() > 0) {
+                    const frame_t& f = stack.back();
+                    result.push_back(regionized::region(f.begin, end, f.level, f.rType));
+                    stack.pop_back();
+                }
+                return;
+            case STEP_EXIT:
+                // (toplevel has no exit token: the stack never runs empty here)
+                it = exitRegion(stack.back(), it, result);
+                stack.pop_back();
+                break;
+            case STEP_ENTER:
+                stack.push_back(sub);
+                break;
         }
+    }
+}
+
+MHPP("public static")
+// compares cursorIterative() with the recursive cursor(), and tree queries and visitors with linear scans over getRegions(). Throws on mismatch
+void regionized::testcases() {
+    const vector<string> texts = {
+        "",
+        "int main(void){ // C comment\r\n    cout << \"hello\" << endl; map<string, vector<int>> m; }",
+        "hello('\\\"') \"she said \\\"hello\\\"\" '\\\\'",
+        "/* a ( */ b // c (\n d [e] {f}",
+        "string raw(u8R\"xxx(bla\"bla)xx)xxx\"); R\"(a)\" LR\"--(b)--\" uR\"x\" U\"u\" L\"l\" u8\"8\" uRx u8",
+        "R\"12345678901234567(too long)12345678901234567\" \"\\",
+        "unterminated ( [ { < \" /* //",
+        "// last line without newline",
+        "a<b>c<<d>>e<f<g>>"};
+    for (const string& t : texts) {
+        vector<region> recursive;
+        string rawExit;
+        cursor(frame_t{t.cbegin(), t.cbegin(), 0, &noExit, TOPLEVEL}, t.cend(), recursive, rawExit);
+        vector<region> iterative;
+        cursorIterative(t.cbegin(), t.cend(), iterative);
+        bool same = recursive.size() == iterative.size();
+        for (size_t ix = 0; same && (ix < recursive.size()); ++ix)
+            same = (recursive[ix].getBegin() == iterative[ix].getBegin()) && (recursive[ix].getEnd() == iterative[ix].getEnd()) &&
+                   (recursive[ix].getLevel() == iterative[ix].getLevel()) && (recursive[ix].getRType() == iterative[ix].getRType());
+        if (!same) throw runtime_error("regionized testcase failed: iterative and recursive results differ on '" + t + "'");
 
-        // search for hierarchic subexpressions
-        for (const auto& [left, right, br_rType] : bracketpairs) {
-            if (tokenFoundAtIt(it, end, left)) {
-                it = cursor(it, it + left.size(), end, level + 1, result, right, br_rType);
-                goto continueMainLoop;
+        // === tree queries against linear scans ===
+        const regionized tree(t.cbegin(), t.cend());
+        auto fail = [&t](const string& what) { throw runtime_error("regionized testcase failed: " + what + " on '" + t + "'"); };
+        for (csit_t it = t.cbegin(); it <= t.cend(); ++it) {
+            size_t innermost = NONE;
+            for (size_t ix = 0; ix < iterative.size(); ++ix)
+                if ((iterative[ix].getBegin() <= it) && (it < iterative[ix].getEnd()) && ((innermost == NONE) || (iterative[ix].getLevel() > iterative[innermost].getLevel())))
+                    innermost = ix;
+            if (tree.innermostContaining(it) != innermost) fail("innermostContaining");
+            for (rType_e rType : {BRK_RND, DQUOTE, DQUOTE_BODY, REM_C}) {
+                size_t starting = NONE;
+                for (size_t ix = 0; (ix < iterative.size()) && (starting == NONE); ++ix)
+                    if (iterative[ix].startsAt(it) && (iterative[ix].getRType() == rType))
+                        starting = ix;
+                if (tree.regionStartingAt(it, rType) != starting) fail("regionStartingAt");
             }
+            if (it == t.cend()) break;
         }
+        for (size_t ixRegion = 0; ixRegion < iterative.size(); ++ixRegion) {
+            vector<size_t> contained;
+            vector<size_t> nested;
+            for (size_t ix = 0; ix < iterative.size(); ++ix) {
+                if ((ix != ixRegion) && iterative[ixRegion].contains(iterative[ix]) && (iterative[ix].getLevel() > iterative[ixRegion].getLevel()))
+                    contained.push_back(ix);
+                if ((ix != ixRegion) && iterative[ixRegion].contains(iterative[ix]) && (iterative[ix].getLevel() == iterative[ixRegion].getLevel() + 1))
+                    nested.push_back(ix);
+            }
+            vector<size_t> d = tree.descendants(ixRegion, INVALID);
+            std::sort(d.begin(), d.end());
+            if ((d != contained) || (tree.children(ixRegion, INVALID) != nested)) fail("descendants / children of region " + to_string(ixRegion));
+            // === visitors see the regions in place, in the same order ===
+            vector<size_t> visited;
+            tree.forEachDescendant(ixRegion, DQUOTE_BODY, [&](const region& r) { visited.push_back(&r - tree.getRegions().data()); });
+            if (visited != tree.descendants(ixRegion, DQUOTE_BODY)) fail("forEachDescendant of region " + to_string(ixRegion));
+        }
+        for (rType_e rType : {INVALID, BRK_RND, DQUOTE}) {
+            vector<size_t> expected;
+            for (size_t ix = 0; ix < iterative.size(); ++ix)
+                if ((rType == INVALID) || (iterative[ix].getRType() == rType))
+                    expected.push_back(ix);
+            vector<size_t> visited;
+            tree.forEachRegion(rType, [&](const region& r) { visited.push_back(&r - tree.getRegions().data()); });
+            if (visited != expected) fail("forEachRegion");
+        }
+    }
 
-    skipRecursion:
-        ++it;
-    continueMainLoop:;
-    }  // while true
+    // === nesting beyond any call stack ===
+    const size_t depth = 1000000;
+    const string deep = string(depth, '(') + string(depth, ')');
+    const regionized deepRegions(deep.cbegin(), deep.cend());
+    const vector<region>& regions = deepRegions.getRegions();
+    if ((regions.size() != depth + 1) || (regions[0].str() != "()") || (regions[0].getLevel() != depth) || (regions[depth - 1].str() != deep))
+        throw runtime_error("regionized testcase failed: deep nesting");
 }
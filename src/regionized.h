@@ -2,15 +2,20 @@
 #ifndef MHPP
 #define MHPP(arg)
 #endif
+#include <functional>
 #include <string>
 #include <vector>
 typedef std::string::const_iterator csit_t;  // shouldn't do this, for the sake of brevity
 class regionizedText;
 
-// Parses C(++) code recursively into list of bracketed-/quoted-/comment regions
+// Parses C(++) code (iteratively, with an explicit stack) into list of bracketed-/quoted-/comment regions, linked as a tree (regions nest properly)
 class regionized {
    public:
     class region;
+    // region index meaning "no such region"
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    // called per region by forEachRegion()
+    typedef std::function<void(const region& r)> regionVisitor_t;
     typedef enum { INVALID,
                    TOPLEVEL,    // input expression
                    BRK_ANG,     // <>
@@ -49,17 +54,90 @@ class regionized {
         rType_e rType;
     };
 
+   private:
+    // one open region while parsing (see cursor)
+    struct frame_t {
+        // start of the region, including its opening token
+        csit_t begin;
+        // start of the region content (behind the opening token)
+        csit_t beginSearch;
+        size_t level;
+        // token that closes the region (empty: runs to end of text)
+        const std::string* tExit;
+        rType_e rType;
+    };
+    // result of lexStep()
+    typedef enum {
+        // end of text
+        STEP_END,
+        // exit token of the current region
+        STEP_EXIT,
+        // opening token of a subregion
+        STEP_ENTER
+    } lexStep_e;
+
     MHPP("begin regionized") // === autogenerated code. Do not edit ===
     public:
     	regionized(const csit_t begin, const csit_t end);
-    	// returns all regions (overlapping, in order of parsing, insertion at end of region)
-    	std::vector<regionized::region> getRegions() const;
+    	// returns all regions (overlapping, in order of parsing, insertion at end of region). Valid as long as this object
+    	const std::vector<regionized::region>& getRegions() const;
+    	// calls visitor for each region of type rType (rType_e::INVALID selects all) in order of parsing, as getRegions()
+    	void forEachRegion(regionized::rType_e rType, const regionized::regionVisitor_t& visitor) const;
+    	// region by index into getRegions()
+    	const regionized::region& getRegion(size_t ixRegion) const;
+    	// number of regions, including TOPLEVEL
+    	size_t getNRegions() const;
+    	// index of the TOPLEVEL region, which contains all others
+    	size_t getRoot() const;
+    	// enclosing region (NONE for the root)
+    	size_t getParent(size_t ixRegion) const;
+    	// first directly nested region in text order (NONE if none)
+    	size_t getFirstChild(size_t ixRegion) const;
+    	// next region with the same parent in text order (NONE if none)
+    	size_t getNextSibling(size_t ixRegion) const;
+    	// region of type rType starting at it (rType_e::INVALID selects all, then the outermost). NONE if none. Binary search
+    	size_t regionStartingAt(csit_t it, regionized::rType_e rType) const;
+    	// directly nested regions of type rType (rType_e::INVALID selects all) in text order
+    	std::vector<size_t> children(size_t ixRegion, regionized::rType_e rType) const;
+    	// all regions nested at any depth in ixRegion, of type rType (rType_e::INVALID selects all) in text order. Cost is the size of the subtree
+    	std::vector<size_t> descendants(size_t ixRegion, regionized::rType_e rType) const;
+    	// calls visitor for the regions descendants() returns, without collecting them
+    	void forEachDescendant(size_t ixRegion, regionized::rType_e rType, const regionized::regionVisitor_t& visitor) const;
+    	// deepest region with it in [begin, end) (NONE if none). Binary search, then up the tree through regions ending before it
+    	size_t innermostContaining(csit_t it) const;
+    	// compares cursorIterative() with the recursive cursor(), and tree queries and visitors with linear scans over getRegions(). Throws on mismatch
+    	static void testcases();
     private:
-    	bool tokenFoundAtIt(const csit_t begin, const csit_t end, const std::string token);
-    	std::string getRawStringTerminatorOrDoubleQuote(const csit_t start, const csit_t end);
-    	csit_t cursor(csit_t begin, csit_t beginSearch, csit_t end, size_t level, std::vector<region>& result, const std::string tExit, rType_e rType);
-    MHPP("end regionized");
+    	// region following ix in a pre-order walk of the subtree of ixRegion (NONE at its end)
+    	size_t nextInSubtree(size_t ix, size_t ixRegion) const;
+    	// links regions into the tree (on first use), from their levels in parsing order (a region closes after all its subregions)
+    	void buildTree() const;
+    	static bool tokenFoundAtIt(const csit_t begin, const csit_t end, const std::string& token);
+    	static std::string getRawStringTerminatorOrDoubleQuote(const csit_t start, const csit_t end);
+    	// advances it within region f up to the end of text, f's exit token or a subregion.
+    	// STEP_ENTER: sub describes the subregion, it points behind its opening token. A raw string's exit token is stored in rawExit (raw strings contain no subregions, so one suffices)
+    	static regionized::lexStep_e lexStep(const regionized::frame_t& f, csit_t& it, csit_t end, regionized::frame_t& sub, std::string& rawExit);
+    	// closes region f at its exit token (at it). Returns the position behind the region
+    	static csit_t exitRegion(const regionized::frame_t& f, csit_t it, std::vector<region>& result);
+    	// parses region f from f.beginSearch up to its exit token (or end) into result, recursing into subregions. Returns the position behind the region
+    	static csit_t cursor(const regionized::frame_t& f, csit_t end, std::vector<region>& result, std::string& rawExit);
+    	// same result as cursor() on the toplevel region, without recursion: open regions are kept on an explicit stack.
+    	// Nesting depth is limited only by memory
+    	static void cursorIterative(csit_t begin, csit_t end, std::vector<region>& result);
+    MHPP("end regionized")
 
    private:
+    // tree links of one region (region indices, NONE if none)
+    struct node_t {
+        size_t parent;
+        // children are linked in text order
+        size_t firstChild;
+        size_t nextSibling;
+    };
+    // in order of parsing (post-order: a region follows its subregions, see getRegions())
     std::vector<region> regions;
+    // tree links by region index (built on first tree query)
+    mutable std::vector<node_t> nodes;
+    // region indices in pre-order i.e. sorted by begin, enclosing region first
+    mutable std::vector<size_t> byBegin;
 };
@@ -1,20 +1,28 @@
 #include "regionizedText.h"
 
+#include <algorithm>
 #include <cassert>
 #include <set>
-using std::set;
+#include <stdexcept>
+using std::set, std::runtime_error;
 MHPP("public")
-regionizedText::regionizedText(const std::string& text) : text(std::make_shared<std::string>(text)), regs(this->text->cbegin(), this->text->cend()) {}
+regionizedText::regionizedText(const std::string& text) : text(std::make_shared<std::string>(text)), regs(this->text->cbegin(), this->text->cend()), lines(), byType() {}
 
 MHPP("public")
-vector<regionized::region> regionizedText::getRegions() const { return regs.getRegions(); }
+// all regions in order of parsing (see regionized::getRegions). Valid as long as this object
+const vector<regionized::region>& regionizedText::getRegions() const { return regs.getRegions(); }
 
 MHPP("public")
-regionized::region regionizedText::getRegion(size_t ixRegion) const {
-    auto v = regs.getRegions();
-    assert(v.size() > ixRegion);
-    return v[ixRegion];
-}
+// region by index into getRegions(). Valid as long as this object
+const regionized::region& regionizedText::getRegion(size_t ixRegion) const { return regs.getRegion(ixRegion); }
+
+MHPP("public")
+// calls visitor for each region of type rType (rType_e::INVALID selects all) in order of parsing
+void regionizedText::forEachRegion(rType_e rType, const regionized::regionVisitor_t& visitor) const { regs.forEachRegion(rType, visitor); }
+
+MHPP("public")
+// regions of the owned text with tree queries
+const regionized& regionizedText::getRegionized() const { return regs; }
 // begin() iterator into owned text
 MHPP("public")
 csit_t regionizedText::begin() const { return text->cbegin(); }
@@ -71,7 +79,7 @@ void regionizedText::mask(string& data, const regionized::region& reg, char mask
 MHPP("public")
 // maps regions filtered by rType from internal text to "data" and fills with char
 void regionizedText::mask(string& data, const vector<regionized::region>& regions, regionized::rType_e rType, char maskChar) const {
-    for (const regionized::region r : regions)
+    for (const regionized::region& r : regions)
         if (r.getRType() == rType) {
             mask(data, r, maskChar);
         }
@@ -80,7 +88,7 @@ void regionizedText::mask(string& data, const vector<regionized::region>& region
 MHPP("public")
 // maps regions filtered by rType from internal text to "data" and fills with char
 void regionizedText::mask(string& data, const vector<regionized::region>& regions, regionized::rType_e rType, char maskChar, char startChar, char endChar) const {
-    for (const regionized::region r : regions)
+    for (const regionized::region& r : regions)
         if (r.getRType() == rType) {
             mask(data, r, maskChar, startChar, endChar);
         }
@@ -89,14 +97,62 @@ void regionizedText::mask(string& data, const vector<regionized::region>& region
 MHPP("public")
 // returns all regions fully contained in iBegin..iEnd, filtered by rType (rType_e::INVALID selects all)
 std::vector<regionized::region> regionizedText::getRegions(csit_t iBegin, csit_t iEnd, rType_e rType) const {
+    // === collect indices to return regions in parsing order, as getRegions() ===
+    vector<size_t> ixs;
+    const vector<size_t>& bucket = regionsOfType(rType);
+    for (auto it = firstStartingAtOrAfter(bucket, iBegin); it != bucket.cend(); ++it) {
+        const regionized::region& r = regs.getRegion(*it);
+        if (r.begin > iEnd) break;
+        if (r.end <= iEnd) ixs.push_back(*it);
+    }
+    std::sort(ixs.begin(), ixs.end());
+
     std::vector<regionized::region> ret;
-    for (const regionized::region r : regs.getRegions())
-        if ((rType == rType_e::INVALID) || (rType == r.getRType()))
-            if ((r.begin >= iBegin) && (r.end <= iEnd))
-                ret.push_back(r);
+    ret.reserve(ixs.size());
+    for (size_t ix : ixs)
+        ret.push_back(regs.getRegion(ix));
     return ret;
 }
 
+MHPP("public")
+// calls visitor for each region fully contained in iBegin..iEnd, filtered by rType (rType_e::INVALID selects all), in text order.
+// Binary search on the index of rType, then proportional to the result (plus regions of rType that start in iBegin..iEnd and enclose iEnd)
+void regionizedText::forEachRegion(csit_t iBegin, csit_t iEnd, rType_e rType, const regionized::regionVisitor_t& visitor) const {
+    const vector<size_t>& bucket = regionsOfType(rType);
+    for (auto it = firstStartingAtOrAfter(bucket, iBegin); it != bucket.cend(); ++it) {
+        const regionized::region& r = regs.getRegion(*it);
+        if (r.begin > iEnd) break;
+        if (r.end <= iEnd) visitor(r);
+    }
+}
+
+MHPP("private")
+// region indices of type rType (rType_e::INVALID: all), sorted by begin. The index is built for all types on first use
+const std::vector<size_t>& regionizedText::regionsOfType(rType_e rType) const {
+    if (byType.size() == 0) {
+        const size_t n = regs.getNRegions();
+        vector<size_t> all(n);
+        for (size_t ix = 0; ix < n; ++ix)
+            all[ix] = ix;
+        // stable: regions starting at the same position keep parsing order
+        std::stable_sort(all.begin(), all.end(), [this](size_t a, size_t b) { return regs.getRegion(a).begin < regs.getRegion(b).begin; });
+
+        vector<vector<size_t>> index(regionized::DQUOTE_BODY + 1);
+        for (size_t ix : all)
+            index[regs.getRegion(ix).getRType()].push_back(ix);
+        index[rType_e::INVALID] = std::move(all);
+        byType = std::move(index);
+    }
+    assert(rType < byType.size());
+    return byType[rType];
+}
+
+MHPP("private")
+// first entry of bucket (see regionsOfType) with begin at or after it
+std::vector<size_t>::const_iterator regionizedText::firstStartingAtOrAfter(const std::vector<size_t>& bucket, csit_t it) const {
+    return std::lower_bound(bucket.cbegin(), bucket.cend(), it, [this](size_t ix, csit_t pos) { return regs.getRegion(ix).begin < pos; });
+}
+
 MHPP("public static")
 // given an iterator it from sOrig, return an iterator to the same position in (same-sized) sDest
 csit_t regionizedText::remapIterator(const std::string& sSrc, const std::string& sDest, const csit_t it) {
@@ -143,32 +199,9 @@ void regionizedText::regionInSource(csit_t iBegin, csit_t iEnd, bool base1, /*ou
     assert(iEnd >= iBegin);
     assert(iBegin >= text->cbegin());
     assert(iEnd <= text->cend());
-    size_t lcount = 0;
-    size_t ccount = 0;
-    const size_t offset = base1 ? 1 : 0;
-    csit_t it = text->cbegin();
-    while (it != iBegin) {
-        if (*it == '\n') {
-            ++lcount;
-            ccount = 0;
-        } else {
-            ++ccount;
-        }
-        ++it;
-    }
-    lineBegin = lcount + offset;
-    charBegin = ccount + offset;
-    while (it != iEnd) {
-        if (*it == '\n') {
-            ++lcount;
-            ccount = 0;
-        } else {
-            ++ccount;
-        }
-        ++it;
-    }
-    lineEnd = lcount + offset;
-    charEnd = ccount + offset;
+    if (!lines)
+        lines = std::make_shared<const lineIndex>(text->data(), text->data() + text->size());
+    lines->regionInSource(iBegin - text->cbegin(), iEnd - text->cbegin(), base1, lineBegin, charBegin, lineEnd, charEnd);
 }
 
 MHPP("private")
@@ -201,32 +234,85 @@ void regionizedText::mask(string& data, csit_t maskBegin, csit_t maskEnd, char m
 }
 
 MHPP("public static")
+// checks parsing of quotes, accessors, range queries against a linear filter and the tree lookups MHPP_keyword::parse uses. Throws on mismatch
 void regionizedText::testcases() {
-    assert(regionizedText(R"---(hello('\"'))---").getRegion(2).str() == string("hello('\\\"')"));  // escaped quote in char
-    assert(regionizedText("hello('a')").getRegion(0).str() == "'a'");
-    //    dumpRegions(regionizedText("print(\"she said \\\"hello\\\"\")"));
+    auto fail = [](const string& what) { throw runtime_error("regionizedText testcase failed: " + what); };
+    if (regionizedText(R"---(hello('\"'))---").getRegion(2).str() != string("hello('\\\"')")) fail("escaped quote in char");
+    if (regionizedText("hello('a')").getRegion(0).str() != "'a'") fail("char literal");
     auto r = regionizedText("\"she said \\\"hello\\\"\"");
     set<size_t> levels;
-    for (auto rr : r.getRegions()) {
+    for (const regionized::region& rr : r.getRegions()) {
         levels.insert(rr.getLevel());
         switch (rr.getLevel()) {
             case 0:
-                assert(rr.str() == "\"she said \\\"hello\\\"\"");
-                assert(rr.getRType() == regionized::TOPLEVEL);
+                if ((rr.str() != "\"she said \\\"hello\\\"\"") || (rr.getRType() != regionized::TOPLEVEL)) fail("escaped quote in string, level 0");
                 break;
             case 1:
-                assert(rr.str() == "\"she said \\\"hello\\\"\"");
-                assert(rr.getRType() == regionized::DQUOTE);
+                if ((rr.str() != "\"she said \\\"hello\\\"\"") || (rr.getRType() != regionized::DQUOTE)) fail("escaped quote in string, level 1");
                 break;
             case 2:
-                assert(rr.str() == "she said \\\"hello\\\"");
-                assert(rr.getRType() == regionized::DQUOTE_BODY);
+                if ((rr.str() != "she said \\\"hello\\\"") || (rr.getRType() != regionized::DQUOTE_BODY)) fail("escaped quote in string, level 2");
                 break;
             default:
-                assert(false);
+                fail("escaped quote in string, unexpected level");
         }
     }
-    assert(levels.size() == 3);
+    if (levels.size() != 3) fail("escaped quote in string, levels");
 
-    //   assert(.getRegion(0).str() == "\"she said \\\"hello\\\"\"");  // escaped quote in string
+    const regionizedText t(R"---(f(a, (b[1]), "x(y)", '(') /* (c) */ { g<h>(i("", ((j)))); } // (k))---");
+    const vector<regionized::region>& all = t.getRegions();
+
+    // === accessors refer to the regions in place ===
+    if (t.getRegionized().getNRegions() != all.size()) fail("getRegionized");
+    for (size_t ix = 0; ix < all.size(); ++ix)
+        if (&t.getRegion(ix) != &all[ix]) fail("getRegion returns a copy");
+    for (int rType = rType_e::INVALID; rType <= rType_e::DQUOTE_BODY; ++rType) {
+        vector<const regionized::region*> expected;
+        for (const regionized::region& rr : all)
+            if ((rType == rType_e::INVALID) || (rType == rr.getRType()))
+                expected.push_back(&rr);
+        vector<const regionized::region*> visited;
+        t.forEachRegion((rType_e)rType, [&visited](const regionized::region& rr) { visited.push_back(&rr); });
+        if (visited != expected) fail("forEachRegion by type");
+    }
+
+    // === range queries match a linear filter over all regions ===
+    for (size_t ixBegin = 0; ixBegin <= t.str().size(); ++ixBegin)
+        for (size_t ixEnd = ixBegin; ixEnd <= t.str().size(); ++ixEnd)
+            for (int rType = rType_e::INVALID; rType <= rType_e::DQUOTE_BODY; ++rType) {
+                const csit_t iBegin = t.begin() + ixBegin;
+                const csit_t iEnd = t.begin() + ixEnd;
+                const string range = " [" + std::to_string(ixBegin) + ", " + std::to_string(ixEnd) + ") type " + std::to_string(rType);
+                vector<const regionized::region*> expected;
+                for (const regionized::region& rr : all)
+                    if (((rType == rType_e::INVALID) || (rType == rr.getRType())) && (rr.begin >= iBegin) && (rr.end <= iEnd))
+                        expected.push_back(&rr);
+
+                const vector<regionized::region> got = t.getRegions(iBegin, iEnd, (rType_e)rType);
+                if (got.size() != expected.size()) fail("getRegions count" + range);
+                for (size_t ix = 0; ix < got.size(); ++ix)
+                    if ((got[ix].begin != expected[ix]->begin) || (got[ix].end != expected[ix]->end) || (got[ix].getRType() != expected[ix]->getRType())) fail("getRegions" + range);
+
+                set<const regionized::region*> visited;
+                csit_t prevBegin = t.begin();
+                t.forEachRegion(iBegin, iEnd, (rType_e)rType, [&](const regionized::region& rr) {
+                    if (rr.begin < prevBegin) fail("forEachRegion order" + range);
+                    prevBegin = rr.begin;
+                    if (!(((rType == rType_e::INVALID) || (rType == rr.getRType())) && (rr.begin >= iBegin) && (rr.end <= iEnd))) fail("forEachRegion filter" + range);
+                    visited.insert(&rr);
+                });
+                if (visited.size() != expected.size()) fail("forEachRegion count" + range);
+            }
+
+    // === lookups of MHPP_keyword::parse: round bracket at the opening bracket, its single double-quoted argument ===
+    const regionizedText k("MHPP(\"begin x\") int a; MHPP (/* \"c\" */ \"public\" ) void f(\"s\");");
+    const regionized& tree = k.getRegionized();
+    vector<string> args;
+    for (size_t pos = k.str().find('('); pos != string::npos; pos = k.str().find('(', pos + 1)) {
+        const size_t ixRndBrk = tree.regionStartingAt(k.begin() + pos, regionized::rType_e::BRK_RND);
+        if (ixRndBrk == regionized::NONE) fail("no round bracket region at '('");
+        for (size_t ixArg : tree.descendants(ixRndBrk, regionized::rType_e::DQUOTE_BODY))
+            args.push_back(tree.getRegion(ixArg).str());
+    }
+    if (args != vector<string>({"begin x", "public", "s"})) fail("MHPP arguments");
 }
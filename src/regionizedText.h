@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include "lineIndex.h"
 #include "regionized.h"
 // "regionized" with ownership of input text copy
 using std::string, std::vector, std::pair, std::shared_ptr;  // project convention
@@ -10,8 +11,14 @@ class regionizedText {
     MHPP("begin regionizedText") // === autogenerated code. Do not edit ===
     public:
     	regionizedText(const std::string& text);
-    	vector<regionized::region> getRegions() const;
-    	regionized::region getRegion(size_t ixRegion) const;
+    	// all regions in order of parsing (see regionized::getRegions). Valid as long as this object
+    	const vector<regionized::region>& getRegions() const;
+    	// region by index into getRegions(). Valid as long as this object
+    	const regionized::region& getRegion(size_t ixRegion) const;
+    	// calls visitor for each region of type rType (rType_e::INVALID selects all) in order of parsing
+    	void forEachRegion(rType_e rType, const regionized::regionVisitor_t& visitor) const;
+    	// regions of the owned text with tree queries
+    	const regionized& getRegionized() const;
     	csit_t begin() const;
     	// end() iterator into owned text
     	csit_t end() const;
@@ -33,6 +40,9 @@ class regionizedText {
     	void mask(string& data, const vector<regionized::region>& regions, regionized::rType_e rType, char maskChar, char startChar, char endChar) const;
     	// returns all regions fully contained in iBegin..iEnd, filtered by rType (rType_e::INVALID selects all)
     	std::vector<regionized::region> getRegions(csit_t iBegin, csit_t iEnd, rType_e rType) const;
+    	// calls visitor for each region fully contained in iBegin..iEnd, filtered by rType (rType_e::INVALID selects all), in text order.
+    	// Binary search on the index of rType, then proportional to the result (plus regions of rType that start in iBegin..iEnd and enclose iEnd)
+    	void forEachRegion(csit_t iBegin, csit_t iEnd, rType_e rType, const regionized::regionVisitor_t& visitor) const;
     	// given an iterator it from sOrig, return an iterator to the same position in (same-sized) sDest
     	static csit_t remapIterator(const std::string& sSrc, const std::string& sDest, const csit_t it);
     	// given an iterator it from external string sExt, return an iterator to the same position in (same-sized) object text
@@ -47,10 +57,15 @@ class regionizedText {
     	void regionInSource(const regionized::region& r, bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const;
     	// returns line-/character position of substring in source
     	void regionInSource(csit_t iBegin, csit_t iEnd, bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const;
+    	// checks parsing of quotes, accessors, range queries against a linear filter and the tree lookups MHPP_keyword::parse uses. Throws on mismatch
     	static void testcases();
     private:
     	// checks whether region points into owned text
     	bool regionIsValid(const regionized::region& r) const;
+    	// region indices of type rType (rType_e::INVALID: all), sorted by begin. The index is built for all types on first use
+    	const std::vector<size_t>& regionsOfType(rType_e rType) const;
+    	// first entry of bucket (see regionsOfType) with begin at or after it
+    	std::vector<size_t>::const_iterator firstStartingAtOrAfter(const std::vector<size_t>& bucket, csit_t it) const;
     	void mask(string& data, csit_t maskBegin, csit_t maskEnd, char maskChar) const;
     	void mask(string& data, csit_t maskBegin, csit_t maskEnd, char maskChar, char startChar, char endChar) const;
     MHPP("end regionizedText")
@@ -58,4 +73,8 @@ class regionizedText {
     // owned copy of input text
     const shared_ptr<const string> text;  // may never change (would invalidate region iterators)
     regionized regs;
+    // built on first regionInSource() call
+    mutable std::shared_ptr<const lineIndex> lines;
+    // region indices sorted by begin, by rType (all regions at rType_e::INVALID). Built on first range query
+    mutable std::vector<std::vector<size_t>> byType;
 };
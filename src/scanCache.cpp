@@ -0,0 +1,104 @@
+#include "scanCache.h"
+
+#include <unistd.h>  // getpid
+
+#include <cstdio>  // rename
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+using std::string, std::vector, std::map, std::runtime_error, std::to_string;
+
+MHPP("private static")
+// first line of every entry. Changes whenever the entry format or codeGen::scan() (other than its pattern) changes
+const std::string scanCache::magic = "makeheaderspp scanCache 3";
+
+MHPP("public")
+// uses (and creates, if needed) directory dir. flags distinguishes command line options and scan patterns that change the output
+scanCache::scanCache(const std::string& dir, const std::string& flags) : dir(dir), salt(0), nTmp(0) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (!std::filesystem::is_directory(dir, ec)) throw runtime_error("failed to create cache directory '" + dir + "'");
+
+    // === entries are reused by other builds with the same format and flags (deterministic: no build time) ===
+    const string id = magic + "\n" + flags + "\n";
+    salt = hash(id.data(), id.data() + id.size(), 0xcbf29ce484222325ULL);
+}
+
+MHPP("public")
+// on hit, returns true and recreates the cached scan() result on body. Safe to call from worker threads
+bool scanCache::lookup(const myRegexRange& body, std::vector<std::vector<myRegexRange>>& decls) const {
+    std::ifstream s(entryName(body), std::ios::binary);
+    if (!s) return false;
+
+    // === header: format and content size (guards against hash collisions) ===
+    string line;
+    if (!std::getline(s, line) || (line != magic)) return false;
+    size_t size;
+    size_t nDecls;
+    if (!(s >> size >> nDecls) || (size != (size_t)(body.end() - body.begin()))) return false;
+
+    // === one line per declaration: number of captures, then begin end ... by capture number ===
+    vector<vector<myRegexRange>> r;
+    for (size_t ixDecl = 0; ixDecl < nDecls; ++ixDecl) {
+        size_t nCapt;
+        if (!(s >> nCapt)) return false;
+        vector<myRegexRange> capt;
+        for (size_t ixCapt = 0; ixCapt < nCapt; ++ixCapt) {
+            size_t b;
+            size_t e;
+            if (!(s >> b >> e) || (b > e) || (e > size)) return false;
+            capt.push_back(body.substr(body.begin() + b, body.begin() + e));
+        }
+        r.push_back(capt);
+    }
+    decls = r;
+    return true;
+}
+
+MHPP("public")
+// stores the scan() result of body. Failure to write is not an error (the entry is simply missing next time). Safe to call from worker threads
+void scanCache::store(const myRegexRange& body, const std::vector<std::vector<myRegexRange>>& decls) {
+    std::ostringstream os;
+    os << magic << "\n"
+       << (body.end() - body.begin()) << " " << decls.size() << "\n";
+    for (const auto& capt : decls) {
+        os << capt.size();
+        for (const auto& range : capt)
+            os << " " << (range.begin() - body.begin()) << " " << (range.end() - body.begin());
+        os << "\n";
+    }
+
+    // === write-then-rename: concurrent runs never see partial entries ===
+    const string fname = entryName(body);
+    const string tmpName = fname + "." + to_string(::getpid()) + "." + to_string(nTmp++) + ".tmp";
+    {
+        std::ofstream s(tmpName, std::ios::binary);
+        s << os.str();
+        s.close();
+        if (!s) {
+            std::remove(tmpName.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmpName.c_str(), fname.c_str()) != 0)
+        std::remove(tmpName.c_str());
+}
+
+MHPP("private")
+// cache file for body
+std::string scanCache::entryName(const myRegexRange& body) const {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash(body.begin(), body.end(), salt));
+    return (std::filesystem::path(dir) / buf).string();
+}
+
+MHPP("private static")
+// 64 bit FNV-1a, continuing from h
+uint64_t scanCache::hash(const char* begin, const char* end, uint64_t h) {
+    for (const char* p = begin; p != end; ++p) {
+        h ^= (unsigned char)*p;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
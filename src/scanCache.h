@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "myRegexRange.h"
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// on-disk cache of codeGen::scan() results, one file per distinct input content (keyed by content hash, entry format, scan pattern and flags).
+// Entries hold capture offsets, which are resolved against the current file contents on lookup.
+class scanCache {
+    MHPP("begin scanCache") // === autogenerated code. Do not edit ===
+    public:
+    	// uses (and creates, if needed) directory dir. flags distinguishes command line options and scan patterns that change the output
+    	scanCache(const std::string& dir, const std::string& flags);
+    	// on hit, returns true and recreates the cached scan() result on body. Safe to call from worker threads
+    	bool lookup(const myRegexRange& body, std::vector<std::vector<myRegexRange>>& decls) const;
+    	// stores the scan() result of body. Failure to write is not an error (the entry is simply missing next time). Safe to call from worker threads
+    	void store(const myRegexRange& body, const std::vector<std::vector<myRegexRange>>& decls);
+    private:
+    	// first line of every entry. Changes whenever the entry format or codeGen::scan() (other than its pattern) changes
+    	static const std::string magic;
+    	// cache file for body
+    	std::string entryName(const myRegexRange& body) const;
+    	// 64 bit FNV-1a, continuing from h
+    	static uint64_t hash(const char* begin, const char* end, uint64_t h);
+    MHPP("end scanCache")
+   private:
+    std::string dir;
+    // hash of format and flags, start value for content hashes
+    uint64_t salt;
+    // makes temporary filenames unique between threads
+    std::atomic<unsigned> nTmp;
+};
@@ -0,0 +1,131 @@
+#include "sectionScanner.h"
+
+#include <stdexcept>
+#include <string_view>
+
+#include "myAppRegex.h"
+using std::string, std::vector, std::runtime_error, std::to_string;
+
+static bool isIdentifierStart(char c) {
+    return (c == '_') || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
+
+static bool isIdentifierChar(char c) {
+    return isIdentifierStart(c) || ((c >= '0') && (c <= '9'));
+}
+
+MHPP("public static")
+// regex equivalent of forEachSection (MHPP_begin with captures indent, classname1, classname2). Defines the capture numbering
+const myRegexBase& sectionScanner::pattern() {
+    static const myRegexBase r = myRegexBase(myAppRegexCt::MHPP_begin).optimized({"indent", "classname1", "classname2"});
+    return r;
+}
+
+MHPP("public static")
+// calls visitor for each section, left to right, with captures numbered as pattern()
+void sectionScanner::forEachSection(const myRegexRange& text, const myRegexRange::matchVisitor_t& visitor) {
+    static const string beginTag = "MHPP(\"begin ";
+    static const string endTag = "MHPP(\"end ";
+    static const size_t ixIndent = pattern().captureIndex("indent");
+    static const size_t ixClassname1 = pattern().captureIndex("classname1");
+    static const size_t ixClassname2 = pattern().captureIndex("classname2");
+    const char* const end = text.end();
+    const char* cursor = text.begin();  // end of the previous section
+    vector<myRegexRange> capt(pattern().getNames().size() + 1, text);
+    while (true) {
+        const char* name1Begin;
+        const char* name1End;
+        const char* begin = findMarker(cursor, end, beginTag, name1Begin, name1End);
+        if (begin == nullptr) return;
+
+        // === the first end marker closes the section (lazy body) ===
+        const char* name2Begin;
+        const char* name2End;
+        const char* endMarker = findMarker(name1End + 2, end, endTag, name2Begin, name2End);
+        if (endMarker == nullptr) return;  // any later begin marker would search the same remainder
+
+        // === indent: leading spaces and tabs, not reaching into the previous section ===
+        const char* indent = begin;
+        while ((indent != cursor) && ((indent[-1] == ' ') || (indent[-1] == '\t')))
+            --indent;
+
+        cursor = name2End + 2;
+        capt[0] = text.substr(indent, cursor);
+        capt[ixIndent] = text.substr(indent, begin);
+        capt[ixClassname1] = text.substr(name1Begin, name1End);
+        capt[ixClassname2] = text.substr(name2Begin, name2End);
+        visitor(capt);
+    }
+}
+
+MHPP("public static")
+// compares results with pattern() on both engines. Throws on mismatch
+void sectionScanner::testcases() {
+    const vector<string> texts = {
+        "",
+        "MHPP(\"begin a\")MHPP(\"end a\")",
+        "x\n \t MHPP(\"begin a::b\") old\n  MHPP(\"end a::b\")\ny",
+        // mismatching names are reported (and rejected by codeGen)
+        "MHPP(\"begin a\") MHPP(\"end b\")",
+        // invalid markers are part of the body or skipped
+        "MHPP(\"begin 1\") MHPP(\"begin a:b\") MHPP(\"begin a::\") MHPP(\"begin c\") MHPP(\"end \") MHPP(\"end c:\") MHPP(\"end c\")",
+        // nested begin: the first end closes the outer section
+        "MHPP(\"begin a\") MHPP(\"begin b\") MHPP(\"end b\") MHPP(\"end a\")",
+        "  MHPP(\"begin a\")MHPP(\"end a\")  MHPP(\"begin b\")\tMHPP(\"end b\") MHPP(\"begin c\") no end",
+        "MHPP(\"begin a\")",
+        "MHPP(\"begin a\" MHPP(\"end a\")"};
+    const myRegexBase::engine_e engine = myRegexBase::getEngine();
+    for (const string& t : texts) {
+        const myRegexRange::root_t root = myRegexRange::own(string(t), "sectionScanner testcase");
+        const myRegexRange& text = *root;
+        vector<vector<string>> expected[2];
+        vector<vector<string>> actual;
+        auto collect = [](vector<vector<string>>& dest) {
+            return [&dest](const vector<myRegexRange>& capt) {
+                vector<string> s;
+                for (const myRegexRange& c : capt)
+                    s.push_back(c.str());
+                dest.push_back(s);
+            };
+        };
+        myRegexBase::setEngine(myRegexBase::ENGINE_STD);
+        text.forEachMatch(pattern(), collect(expected[0]));
+        myRegexBase::setEngine(myRegexBase::ENGINE_NFA);
+        text.forEachMatch(pattern(), collect(expected[1]));
+        myRegexBase::setEngine(engine);
+        forEachSection(text, collect(actual));
+        if ((actual != expected[0]) || (actual != expected[1])) throw runtime_error("sectionScanner testcase failed on '" + t + "'");
+    }
+}
+
+MHPP("private static")
+// end of the classname starting at p (p if none): identifier, optionally followed by ::identifier etc
+const char* sectionScanner::classnameEnd(const char* p, const char* end) {
+    const char* r = p;
+    while (true) {
+        // === identifier ===
+        if ((p == end) || !isIdentifierStart(*p)) return r;
+        ++p;
+        while ((p != end) && isIdentifierChar(*p))
+            ++p;
+        r = p;
+        // === "::" continues only if followed by another identifier ===
+        if ((end - p < 2) || (p[0] != ':') || (p[1] != ':')) return r;
+        p += 2;
+    }
+}
+
+MHPP("private static")
+// first valid marker (tag classname "\")") at or after p (nullptr if none). nameBegin/nameEnd receive the classname
+const char* sectionScanner::findMarker(const char* p, const char* end, const std::string& tag, const char*& nameBegin, const char*& nameEnd) {
+    const std::string_view all(p, end - p);
+    size_t pos = 0;
+    while (true) {
+        pos = all.find(tag, pos);
+        if (pos == std::string_view::npos) return nullptr;
+        nameBegin = p + pos + tag.size();
+        nameEnd = classnameEnd(nameBegin, end);
+        if ((nameEnd != nameBegin) && (end - nameEnd >= 2) && (nameEnd[0] == '"') && (nameEnd[1] == ')')) return p + pos;
+        ++pos;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "myRegexBase.h"
+#include "myRegexRange.h"
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// finds MHPP("begin ...") ... MHPP("end ...") sections as myAppRegex::MHPP_begin() would, without a regex engine.
+// Sections of generated code may be megabytes long: the lazy body match of std::regex recurses per character (stack overflow), the NFA steps every character through its VM.
+// Here, cost is one memchr-driven search per marker and stack depth is constant
+class sectionScanner {
+    MHPP("begin sectionScanner") // === autogenerated code. Do not edit ===
+    public:
+    	// regex equivalent of forEachSection (MHPP_begin with captures indent, classname1, classname2). Defines the capture numbering
+    	static const myRegexBase& pattern();
+    	// calls visitor for each section, left to right, with captures numbered as pattern()
+    	static void forEachSection(const myRegexRange& text, const myRegexRange::matchVisitor_t& visitor);
+    	// compares results with pattern() on both engines. Throws on mismatch
+    	static void testcases();
+    private:
+    	// end of the classname starting at p (p if none): identifier, optionally followed by ::identifier etc
+    	static const char* classnameEnd(const char* p, const char* end);
+    	// first valid marker (tag classname "\")") at or after p (nullptr if none). nameBegin/nameEnd receive the classname
+    	static const char* findMarker(const char* p, const char* end, const std::string& tag, const char*& nameBegin, const char*& nameEnd);
+    MHPP("end sectionScanner")
+};
@@ -0,0 +1,197 @@
+#include "serverMode.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>  // strncpy
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+using std::string, std::vector, std::map, std::runtime_error, std::cout, std::cerr, std::endl;
+
+MHPP("private static")
+// sent instead of a filename to shut down the server
+const std::string serverMode::stopRequest = "\x01stop";
+
+MHPP("private static")
+// a connection that sends no data for this long is answered with "error: timeout" and closed
+const int serverMode::requestTimeout_s = 2;
+
+// fills a sockaddr_un for path
+static sockaddr_un unixAddr(const string& socketPath) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) throw runtime_error("socket path too long: '" + socketPath + "'");
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+MHPP("public static")
+// serves requests until a client sends the stop request. cg must have completed pass1 on filenames
+void serverMode::serve(const std::string& socketPath, codeGen& cg, const std::vector<std::string>& filenames, workerPool& pool) {
+    map<string, string> filenameByPath;
+    for (const string& f : filenames)
+        filenameByPath[absPath(f)] = f;
+    removeStaleSocket(socketPath);
+
+    // === initial generation (same as a regular run) ===
+    cg.regenerate({}, pool);
+
+    const int sfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sfd < 0) throw runtime_error("failed to create socket");
+    const sockaddr_un addr = unixAddr(socketPath);
+    if ((::bind(sfd, (const sockaddr*)&addr, sizeof(addr)) != 0) || (::listen(sfd, 16) != 0)) {
+        ::close(sfd);
+        throw runtime_error("failed to listen on '" + socketPath + "'");
+    }
+    cout << "makeheaderspp: serving " << filenames.size() << " files on " << socketPath << endl;
+
+    bool stop = false;
+    while (!stop) {
+        const int fd = ::accept4(sfd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        serveOne(fd, cg, filenameByPath, pool, stop);
+        ::close(fd);
+    }
+    ::close(sfd);
+    ::unlink(socketPath.c_str());
+}
+
+MHPP("public static")
+// sends changed files to the server and waits for regeneration. Returns false on error (message printed)
+bool serverMode::request(const std::string& socketPath, const std::vector<std::string>& filenames) {
+    string msg;
+    for (const string& f : filenames)
+        msg += absPath(f) + "\n";
+    const string reply = transact(socketPath, msg);
+    if (reply == "ok") return true;
+    cerr << reply << endl;
+    return false;
+}
+
+MHPP("public static")
+// asks the server to exit
+bool serverMode::requestStop(const std::string& socketPath) {
+    return transact(socketPath, stopRequest + "\n") == "ok";
+}
+
+MHPP("private static")
+// handles one connection
+void serverMode::serveOne(int fd, codeGen& cg, const std::map<std::string, std::string>& filenameByPath, workerPool& pool, bool& stop) {
+    // === read request up to empty line (connections are served one at a time: a stalled client must not block the others) ===
+    const timeval timeout = {requestTimeout_s, 0};
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) {
+        writeAll(fd, "error: failed to set timeout\n");
+        return;
+    }
+    string msg;
+    char buf[4096];
+    while ((msg != "\n") && (msg.find("\n\n") == string::npos)) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            writeAll(fd, "error: timeout\n");
+            return;
+        }
+        if (n <= 0) break;
+        msg.append(buf, n);
+    }
+
+    string reply = "ok\n";
+    try {
+        vector<string> changed;
+        size_t pos = 0;
+        while (pos < msg.size()) {
+            const size_t eol = msg.find('\n', pos);
+            const string line = msg.substr(pos, eol == string::npos ? string::npos : eol - pos);
+            pos = (eol == string::npos) ? msg.size() : eol + 1;
+            if (line.size() == 0) break;
+            if (line == stopRequest) {
+                stop = true;
+                continue;
+            }
+            auto it = filenameByPath.find(line);
+            if (it == filenameByPath.end()) throw runtime_error("'" + line + "' is not one of the server's files");
+            changed.push_back(it->second);
+        }
+        if (!stop)
+            cg.regenerate(changed, pool);
+    } catch (std::exception& e) {
+        reply = string("error: ") + e.what() + "\n";
+    }
+    writeAll(fd, reply);
+}
+
+MHPP("private static")
+// sends a request, returns the reply (without newline)
+std::string serverMode::transact(const std::string& socketPath, const std::string& msg) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) throw runtime_error("failed to create socket");
+    const sockaddr_un addr = unixAddr(socketPath);
+    if (::connect(fd, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        ::close(fd);
+        throw runtime_error("failed to connect to server on '" + socketPath + "'");
+    }
+    if (!writeAll(fd, msg + "\n")) {
+        ::close(fd);
+        throw runtime_error("failed to send request to '" + socketPath + "'");
+    }
+    string reply;
+    char buf[4096];
+    while (true) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        reply.append(buf, n);
+    }
+    ::close(fd);
+    while (reply.size() > 0 && reply.back() == '\n')
+        reply.pop_back();
+    return reply;
+}
+
+MHPP("private static")
+// removes the socket left behind by a server that no longer runs. Throws if socketPath is not a socket or a server answers on it
+void serverMode::removeStaleSocket(const std::string& socketPath) {
+    struct stat st;
+    if (::lstat(socketPath.c_str(), &st) != 0) {
+        if (errno == ENOENT) return;
+        throw runtime_error("failed to access '" + socketPath + "'");
+    }
+    if (!S_ISSOCK(st.st_mode)) throw runtime_error("'" + socketPath + "' exists and is not a socket");
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) throw runtime_error("failed to create socket");
+    const sockaddr_un addr = unixAddr(socketPath);
+    const bool isLive = (::connect(fd, (const sockaddr*)&addr, sizeof(addr)) == 0);
+    ::close(fd);
+    if (isLive) throw runtime_error("server already running on '" + socketPath + "'");
+    if (::unlink(socketPath.c_str()) != 0) throw runtime_error("failed to remove stale socket '" + socketPath + "'");
+}
+
+MHPP("private static")
+// absolute, normalized path (server and client may have different working directories)
+std::string serverMode::absPath(const std::string& fname) {
+    return std::filesystem::absolute(fname).lexically_normal().string();
+}
+
+MHPP("private static")
+bool serverMode::writeAll(int fd, const std::string& data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        // (a peer that hung up must not kill the server with SIGPIPE)
+        const ssize_t n = ::send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        pos += n;
+    }
+    return true;
+}
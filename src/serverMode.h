@@ -0,0 +1,35 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+#include "codeGen.h"
+#include "workerPool.h"
+
+// resident process keeping parsed files in memory, regenerating on request from a client over a Unix domain socket.
+// Protocol: client sends absolute filenames (one per line, empty line terminates), server replies "ok\n" or "error: <message>\n".
+class serverMode {
+    MHPP("begin serverMode") // === autogenerated code. Do not edit ===
+    public:
+    	// serves requests until a client sends the stop request. cg must have completed pass1 on filenames
+    	static void serve(const std::string& socketPath, codeGen& cg, const std::vector<std::string>& filenames, workerPool& pool);
+    	// sends changed files to the server and waits for regeneration. Returns false on error (message printed)
+    	static bool request(const std::string& socketPath, const std::vector<std::string>& filenames);
+    	// asks the server to exit
+    	static bool requestStop(const std::string& socketPath);
+    private:
+    	// sent instead of a filename to shut down the server
+    	static const std::string stopRequest;
+    	// a connection that sends no data for this long is answered with "error: timeout" and closed
+    	static const int requestTimeout_s;
+    	// handles one connection
+    	static void serveOne(int fd, codeGen& cg, const std::map<std::string, std::string>& filenameByPath, workerPool& pool, bool& stop);
+    	// sends a request, returns the reply (without newline)
+    	static std::string transact(const std::string& socketPath, const std::string& msg);
+    	// removes the socket left behind by a server that no longer runs. Throws if socketPath is not a socket or a server answers on it
+    	static void removeStaleSocket(const std::string& socketPath);
+    	// absolute, normalized path (server and client may have different working directories)
+    	static std::string absPath(const std::string& fname);
+    	static bool writeAll(int fd, const std::string& data);
+    MHPP("end serverMode")
+};
@@ -142,6 +142,7 @@ std::tuple<string::iterator, string::iterator> stringRegion::beginEnd(string& s)
 MHPP("public")
 // returns line-/character position of substring in source
 void stringRegion::regionInSource(bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const {
+    // (single lookup: a linear scan up to offsetEnd is cheaper than building a lineIndex over the whole string)
     size_t lcount = 0;
     size_t ccount = 0;
 
@@ -173,6 +174,12 @@ void stringRegion::regionInSource(bool base1, /*out*/ size_t& lineBegin, size_t&
     charEnd = ccount + offset;
 }
 
+MHPP("public")
+// returns line-/character position of substring in source, using an index of the referenced string (reuse it for many lookups on the same string)
+void stringRegion::regionInSource(const lineIndex& lines, bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const {
+    lines.regionInSource(offsetBegin, offsetEnd, base1, lineBegin, charBegin, lineEnd, charEnd);
+}
+
 // #define TEST_STRINGREGION
 #ifdef TEST_STRINGREGION
 #include <iostream>
@@ -4,6 +4,8 @@
 #include <tuple>
 #include <vector>
 
+#include "lineIndex.h"
+
 using std::string, std::pair, std::vector;
 #ifndef MHPP
 #define MHPP(arg)  // see https://github.com/mnentwig/makeheaderspp
@@ -46,6 +48,8 @@ class stringRegion {
     	std::tuple<string::iterator, string::iterator> beginEnd(string& s) const;
     	// returns line-/character position of substring in source
     	void regionInSource(bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const;
+    	// returns line-/character position of substring in source, using an index of the referenced string (reuse it for many lookups on the same string)
+    	void regionInSource(const lineIndex& lines, bool base1, /*out*/ size_t& lineBegin, size_t& charBegin, size_t& lineEnd, size_t& charEnd) const;
     private:
     	// construct region of regex submatch in sBegin..sEnd
     	stringRegion(const string::const_iterator sBegin, const string::const_iterator sEnd, const std::ssub_match& subMatch);
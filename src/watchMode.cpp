@@ -0,0 +1,79 @@
+#include "watchMode.h"
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+using std::string, std::vector, std::map, std::set, std::pair, std::runtime_error, std::cout, std::cerr, std::endl;
+
+MHPP("public static")
+// runs until interrupted. cg must have completed pass1 on filenames
+void watchMode::watch(codeGen& cg, const std::vector<std::string>& filenames, workerPool& pool) {
+    // === initial generation (same as a regular run) ===
+    for (const string& f : cg.regenerate({}, pool))
+        cout << "updated " << f << endl;
+
+    const int fd = ::inotify_init1(IN_CLOEXEC);
+    if (fd < 0) throw runtime_error("inotify_init1 failed");
+
+    // === one watch per directory, files identified by (watch, name) ===
+    map<string, int> wdByDir;
+    map<pair<int, string>, string> filenameByWatchAndName;
+    for (const string& f : filenames) {
+        const std::filesystem::path p(f);
+        const string dir = p.has_parent_path() ? p.parent_path().string() : string(".");
+        auto it = wdByDir.find(dir);
+        if (it == wdByDir.end()) {
+            // files are replaced by editors in various ways: written in place, renamed over, deleted and recreated
+            const int wd = ::inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd < 0) {
+                ::close(fd);
+                throw runtime_error("failed to watch directory '" + dir + "'");
+            }
+            it = wdByDir.insert({dir, wd}).first;
+        }
+        filenameByWatchAndName[{it->second, p.filename().string()}] = f;
+    }
+    cout << "makeheaderspp: watching " << filenames.size() << " files in " << wdByDir.size() << " directories" << endl;
+
+    alignas(inotify_event) char buf[16384];
+    while (true) {
+        // === collect events until the burst (e.g. "save all") settles ===
+        set<string> changed;
+        int timeoutMs = -1;  // block until the first event
+        while (true) {
+            pollfd pfd = {fd, POLLIN, 0};
+            const int r = ::poll(&pfd, 1, timeoutMs);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) throw runtime_error("poll on inotify failed");
+            if (r == 0) break;  // quiet for timeoutMs
+            const ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw runtime_error("read from inotify failed");
+            for (ssize_t pos = 0; pos < n;) {
+                const inotify_event* e = reinterpret_cast<const inotify_event*>(buf + pos);
+                pos += sizeof(inotify_event) + e->len;
+                if (e->len == 0) continue;
+                auto it = filenameByWatchAndName.find({e->wd, string(e->name)});
+                if (it != filenameByWatchAndName.end())
+                    changed.insert(it->second);
+            }
+            timeoutMs = 50;
+        }
+        if (changed.size() == 0) continue;
+
+        // === regenerate. Errors (e.g. half-edited code) are reported, watching continues ===
+        try {
+            for (const string& f : cg.regenerate(vector<string>(changed.begin(), changed.end()), pool))
+                cout << "updated " << f << endl;
+        } catch (std::exception& e) {
+            cerr << "error: " << e.what() << endl;
+        }
+    }
+}
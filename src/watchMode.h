@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "codeGen.h"
+#include "workerPool.h"
+
+// watches the directories of the processed files with inotify and regenerates incrementally whenever one of the files changes
+class watchMode {
+    MHPP("begin watchMode") // === autogenerated code. Do not edit ===
+    public:
+    	// runs until interrupted. cg must have completed pass1 on filenames
+    	static void watch(codeGen& cg, const std::vector<std::string>& filenames, workerPool& pool);
+    MHPP("end watchMode")
+};
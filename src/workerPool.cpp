@@ -0,0 +1,79 @@
+#include "workerPool.h"
+
+#include <cassert>
+using std::vector, std::mutex, std::unique_lock, std::exception_ptr;
+
+MHPP("public")
+// starts nThreads workers (none if nThreads <= 1: jobs run serially in the caller's thread)
+workerPool::workerPool(size_t nThreads) : threads(), mtx(), cvWork(), cvDone(), job(nullptr), nJobs(0), nextJob(0), nPending(0), errors(), shutdown(false) {
+    if (nThreads <= 1) return;
+    for (size_t ix = 0; ix < nThreads; ++ix)
+        threads.push_back(std::thread(&workerPool::workerMain, this));
+}
+
+MHPP("public")
+workerPool::~workerPool() {
+    {
+        unique_lock<mutex> lock(mtx);
+        shutdown = true;
+    }
+    cvWork.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+MHPP("public")
+// runs job(0)...job(nJobs-1), returns when all are done. If jobs fail, the exception of the lowest-numbered failed job is rethrown
+void workerPool::run(size_t nJobs, const job_t& job) {
+    if (threads.size() == 0) {
+        // serial mode: same job order and error semantics as threaded mode
+        exception_ptr firstError;
+        for (size_t ix = 0; ix < nJobs; ++ix)
+            try {
+                job(ix);
+            } catch (...) {
+                if (!firstError) firstError = std::current_exception();
+            }
+        if (firstError) std::rethrow_exception(firstError);
+        return;
+    }
+
+    unique_lock<mutex> lock(mtx);
+    assert(this->job == nullptr && "run() is not reentrant");
+    this->job = &job;
+    this->nJobs = nJobs;
+    nextJob = 0;
+    nPending = nJobs;
+    errors.assign(nJobs, nullptr);
+    cvWork.notify_all();
+    cvDone.wait(lock, [this] { return nPending == 0; });
+    this->job = nullptr;
+    this->nJobs = 0;
+    nextJob = 0;
+    for (const exception_ptr& e : errors)
+        if (e) std::rethrow_exception(e);
+}
+
+MHPP("public")
+// number of jobs that may run concurrently
+size_t workerPool::size() const { return threads.size() > 0 ? threads.size() : 1; }
+
+MHPP("private")
+void workerPool::workerMain() {
+    unique_lock<mutex> lock(mtx);
+    while (true) {
+        cvWork.wait(lock, [this] { return shutdown || (nextJob < nJobs); });
+        if (shutdown) return;
+        const size_t ix = nextJob++;
+        lock.unlock();
+        exception_ptr e;
+        try {
+            (*job)(ix);
+        } catch (...) {
+            e = std::current_exception();
+        }
+        lock.lock();
+        errors[ix] = e;
+        if (--nPending == 0) cvDone.notify_all();
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef MHPP
+#define MHPP(arg)  // arg is for makeheaderspp.exe, to be ignored by compiler
+#endif
+
+// fixed set of worker threads for independent, numbered jobs. With a single thread, jobs run in the caller's thread.
+class workerPool {
+   public:
+    // job function, called with the job index
+    typedef std::function<void(size_t)> job_t;
+    MHPP("begin workerPool") // === autogenerated code. Do not edit ===
+    public:
+    	// starts nThreads workers (none if nThreads <= 1: jobs run serially in the caller's thread)
+    	workerPool(size_t nThreads);
+    	~workerPool();
+    	// runs job(0)...job(nJobs-1), returns when all are done. If jobs fail, the exception of the lowest-numbered failed job is rethrown
+    	void run(size_t nJobs, const job_t& job);
+    	// number of jobs that may run concurrently
+    	size_t size() const;
+    private:
+    	void workerMain();
+    MHPP("end workerPool")
+   private:
+    workerPool(const workerPool&) = delete;
+    workerPool& operator=(const workerPool&) = delete;
+    std::vector<std::thread> threads;
+    // guards all members below
+    std::mutex mtx;
+    // signals new jobs or shutdown to workers
+    std::condition_variable cvWork;
+    // signals completion of the last pending job to run()
+    std::condition_variable cvDone;
+    // job function of the ongoing run() call
+    const job_t* job;
+    size_t nJobs;
+    // next job index to hand out
+    size_t nextJob;
+    // jobs handed out or waiting, not yet completed
+    size_t nPending;
+    // exception (if any) by job index
+    std::vector<std::exception_ptr> errors;
+    bool shutdown;
+};
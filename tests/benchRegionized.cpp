@@ -0,0 +1,116 @@
+// benchmark: regionized (bracket / quote / comment regions) throughput on the given source files, each parsed repeatedly.
+// Then the cost of reading the parsed regions: by copy (as getRegions() used to return), by const reference and by visitor,
+// and of indexing every region of a file through regionizedText::getRegion(ix), which used to copy all regions of the file per call.
+// Build and run with "make bench"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fileIngest.h"
+#include "regionized.h"
+#include "regionizedText.h"
+using std::string, std::vector, std::cout;
+
+int main(int argc, char** argv) {
+    vector<string> texts;
+    size_t size = 0;
+    for (int ix = 1; ix < argc; ++ix) {
+        texts.push_back(fileIngest::readFile(argv[ix]));
+        size += texts.back().size();
+    }
+    if (size == 0) {
+        cout << "usage: " << argv[0] << " file1.cpp file2.h ...\n";
+        return 1;
+    }
+
+    const size_t nBytes = 32000000;
+    size_t nRegions = 0;
+    size_t nParsed = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    while (nParsed < nBytes) {
+        for (const string& t : texts)
+            nRegions += regionized(t.cbegin(), t.cend()).getRegions().size();
+        nParsed += size;
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    cout << "regionized: " << nParsed / 1e6 << " MB in " << s * 1000 << " ms, " << nParsed / s / 1e6 << " MB/s, " << nRegions * 1000 / nParsed << " regions per kB\n";
+
+    // === access: count DQUOTE regions of every file, repeatedly ===
+    vector<regionized> parsed;
+    parsed.reserve(texts.size());
+    for (const string& t : texts)
+        parsed.emplace_back(t.cbegin(), t.cend());
+    const size_t nPasses = 200;
+    size_t nVisited = 0;
+    auto report = [&](const char* what, std::chrono::steady_clock::time_point tStart, size_t n) {
+        const double sAccess = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+        cout << "regionized access by " << what << ": " << sAccess * 1e9 / nVisited << " ns per region (" << n << " DQUOTE)\n";
+    };
+    for (const regionized& r : parsed)
+        nVisited += r.getRegions().size() * nPasses;
+
+    size_t nCopy = 0;
+    const auto tCopy = std::chrono::steady_clock::now();
+    for (size_t ix = 0; ix < nPasses; ++ix)
+        for (const regionized& r : parsed) {
+            const vector<regionized::region> copy = r.getRegions();
+            for (const regionized::region& reg : copy)
+                nCopy += reg.getRType() == regionized::DQUOTE;
+        }
+    report("copy", tCopy, nCopy);
+
+    size_t nRef = 0;
+    const auto tRef = std::chrono::steady_clock::now();
+    for (size_t ix = 0; ix < nPasses; ++ix)
+        for (const regionized& r : parsed)
+            for (const regionized::region& reg : r.getRegions())
+                nRef += reg.getRType() == regionized::DQUOTE;
+    report("reference", tRef, nRef);
+
+    size_t nVisitor = 0;
+    const auto tVisitor = std::chrono::steady_clock::now();
+    for (size_t ix = 0; ix < nPasses; ++ix)
+        for (const regionized& r : parsed)
+            r.forEachRegion(regionized::DQUOTE, [&nVisitor](const regionized::region&) { ++nVisitor; });
+    report("visitor", tVisitor, nVisitor);
+
+    // === regionizedText::getRegion(ix) for every region of every file. The old version (reproduced here: copy all regions, then index)
+    // costs one copy of the file's regions per call, quadratic over a file: it runs on the first nOldPerFile indices only and is extrapolated ===
+    vector<regionizedText> parsedTexts;
+    parsedTexts.reserve(texts.size());
+    for (const string& t : texts)
+        parsedTexts.emplace_back(t);
+    const size_t nOldPerFile = 200;
+    size_t nOldCalls = 0;
+    size_t nOld = 0;
+    double sOldFull = 0;  // extrapolated to all indices
+    for (const regionizedText& rt : parsedTexts) {
+        const size_t n = rt.getRegions().size();
+        const size_t nCalls = std::min(n, nOldPerFile);
+        const auto tOld = std::chrono::steady_clock::now();
+        for (size_t ix = 0; ix < nCalls; ++ix) {
+            const vector<regionized::region> copy = rt.getRegions();
+            nOld += copy[ix].getRType() == regionized::DQUOTE;
+        }
+        const double sOld = std::chrono::duration<double>(std::chrono::steady_clock::now() - tOld).count();
+        if (nCalls > 0) sOldFull += sOld * n / nCalls;
+        nOldCalls += nCalls;
+    }
+
+    size_t nNewCalls = 0;
+    size_t nNew = 0;
+    const auto tNew = std::chrono::steady_clock::now();
+    for (size_t ix = 0; ix < nPasses; ++ix)
+        for (const regionizedText& rt : parsedTexts)
+            for (size_t ixRegion = 0; ixRegion < rt.getRegions().size(); ++ixRegion) {
+                nNew += rt.getRegion(ixRegion).getRType() == regionized::DQUOTE;
+                ++nNewCalls;
+            }
+    const double sNew = std::chrono::duration<double>(std::chrono::steady_clock::now() - tNew).count();
+    cout << "regionizedText::getRegion by copy (old): " << sOldFull * 1e9 / (nNewCalls / nPasses) << " ns per call, " << sOldFull * 1000 << " ms per pass over all regions (extrapolated from "
+         << nOldCalls << " calls, " << nOld << " DQUOTE)\n";
+    cout << "regionizedText::getRegion by reference: " << sNew * 1e9 / nNewCalls << " ns per call, " << sNew * 1000 / nPasses << " ms per pass over all regions (" << nNew / nPasses << " DQUOTE)\n";
+    return 0;
+}
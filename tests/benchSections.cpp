@@ -0,0 +1,66 @@
+// benchmark: sectionScanner against the MHPP_begin regex (std::regex, myRegexNfa) on generated multi-megabyte sources.
+// Build and run with "make bench"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "myRegexBase.h"
+#include "myRegexRange.h"
+#include "sectionScanner.h"
+using std::string, std::vector, std::cout;
+
+// source with nSections sections of sectionSize bytes of declarations each, plus definitions in between
+static string makeSource(size_t nSections, size_t sectionSize) {
+    string r;
+    for (size_t ix = 0; ix < nSections; ++ix) {
+        const string name = "class" + std::to_string(ix);
+        r += "class " + name + " {\n    MHPP(\"" + string("begin ") + name + "\") // === autogenerated code. Do not edit ===\n";
+        const size_t bodyStart = r.size();
+        while (r.size() - bodyStart < sectionSize)
+            r += "    \tvoid method" + std::to_string(r.size()) + "(const std::string& arg, int n); // comment\n";
+        r += "    MHPP(\"" + string("end ") + name + "\")\n};\n\n";
+        r += "MHPP(\"public\")\nvoid " + name + "::method0(const std::string& arg, int n) {}\n\n";
+    }
+    return r;
+}
+
+// runs fn (which returns the number of sections found) and prints throughput
+template <typename fn_t>
+static void measure(const string& label, const string& text, size_t nExpected, fn_t fn) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const size_t n = fn();
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    cout << "\t" << label << ": " << s * 1000 << " ms, " << text.size() / s / 1e6 << " MB/s" << (n == nExpected ? "" : " (WRONG RESULT)") << "\n";
+}
+
+int main() {
+    struct {
+        size_t nSections;
+        size_t sectionSize;
+    } cases[] = {{2000, 2000}, {2000, 8000}, {1, 4000000}, {4, 4000000}};
+    // libstdc++ matches the lazy section body recursively, one stack frame per character
+    const size_t maxStdRegexSection = 10000;
+    for (const auto& c : cases) {
+        const string text = makeSource(c.nSections, c.sectionSize);
+        const myRegexRange::root_t root = myRegexRange::own(string(text), "bench");
+        const myRegexRange& all = *root;
+        cout << c.nSections << " sections of " << c.sectionSize << " bytes (" << text.size() / 1e6 << " MB)\n";
+        auto count = [&](auto matchAll) {
+            return [&all, matchAll]() {
+                size_t n = 0;
+                matchAll(all, [&n](const vector<myRegexRange>&) { ++n; });
+                return n;
+            };
+        };
+        measure("sectionScanner", text, c.nSections, count([](const myRegexRange& t, const myRegexRange::matchVisitor_t& v) { sectionScanner::forEachSection(t, v); }));
+        myRegexBase::setEngine(myRegexBase::ENGINE_NFA);
+        measure("myRegexNfa    ", text, c.nSections, count([](const myRegexRange& t, const myRegexRange::matchVisitor_t& v) { t.forEachMatch(sectionScanner::pattern(), v); }));
+        myRegexBase::setEngine(myRegexBase::ENGINE_STD);
+        if (c.sectionSize <= maxStdRegexSection)
+            measure("std::regex    ", text, c.nSections, count([](const myRegexRange& t, const myRegexRange::matchVisitor_t& v) { t.forEachMatch(sectionScanner::pattern(), v); }));
+        else
+            cout << "\tstd::regex    : skipped (stack overflow on sections of this size)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+// testcase source for --depfile: sections filled from two source files (names need escaping, see makefile) and from this file
+#ifndef MHPP
+#define MHPP(arg)
+#endif
+
+class depA {
+    MHPP("begin depA") // === autogenerated code. Do not edit ===
+    public:
+    	void f();
+    	void g();
+    MHPP("end depA")
+};
+
+class depB {
+    MHPP("begin depB") // === autogenerated code. Do not edit ===
+    public:
+    	inline void h();
+    MHPP("end depB")
+};
+
+MHPP("public")
+inline void depB::h() {}
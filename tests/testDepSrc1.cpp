@@ -0,0 +1,5 @@
+// testcase source for --depfile (copied to a filename with a space)
+#include "testDep.h"
+
+MHPP("public")
+void depA::f() {}
@@ -3,6 +3,7 @@
 // then run makeheaderspp.exe src/testPImpl.cpp to regenerate it
 #include <cassert>   // using assert in main()
 #include <iostream>  // print hello
+#include <map>       // nested template arguments for pImpl forwarding
 #include <memory>    // std::shared_ptr for pImpl wrapper
 #include <vector>    // using vector for demo
 #define MHPP(arg)
@@ -20,6 +21,7 @@ class mySuperComplexQueue {
     public:
     	mySuperComplexQueue(int x, int y, int z);
     	void push(int x);
+    	void pushAll(const std::map<int, std::vector<std::pair<int, int>>>& items /* by priority, lowest first */, bool /*swapped*/ second);
     	int pop();
     	size_t size() const noexcept;
     MHPP("end mySuperComplexQueue")
@@ -34,6 +36,13 @@ mySuperComplexQueue::mySuperComplexQueue(int x, int y, int z) : body({x, y}) { b
 MHPP("public pImpl=myScqInputApi")
 void mySuperComplexQueue::push(int x) { body.push_back(x); }
 
+MHPP("public pImpl=myScqInputApi")
+void mySuperComplexQueue::pushAll(const std::map<int, std::vector<std::pair<int, int>>>& items /* by priority, lowest first */, bool /*swapped*/ second) {
+    for (const auto& [prio, pairs] : items)
+        for (const auto& p : pairs)
+            body.push_back(second ? p.second : p.first);
+}
+
 MHPP("public pImpl=myScqOutputApi")
 int mySuperComplexQueue::pop() {
     int tmp = body.back();
@@ -53,6 +62,7 @@ class myScqInputApi {
     public:
     	myScqInputApi(std::shared_ptr<mySuperComplexQueue> pImpl);
     	void push (int x);
+    	void pushAll (const std::map<int, std::vector<std::pair<int, int>>>& items /* by priority, lowest first */, bool /*swapped*/ second);
     	size_t size () const noexcept;
     protected:
     	std::shared_ptr<mySuperComplexQueue> pImpl;
@@ -83,6 +93,9 @@ MHPP("begin myScqInputApi_impl") // === autogenerated code. Do not edit ===
 	void myScqInputApi::push(int x){
 		return pImpl->push(x);
 	}
+	void myScqInputApi::pushAll(const std::map<int, std::vector<std::pair<int, int>>>& items /* by priority, lowest first */, bool /*swapped*/ second){
+		return pImpl->pushAll(items, second);
+	}
 	size_t myScqInputApi::size() const noexcept{
 		return pImpl->size();
 	}
@@ -115,9 +128,11 @@ int main(void) {
     // use the objects...
     apiObjectForSource.push(40);
     apiObjectForSource.push(50);
-    assert(apiObjectForSource.size() == 5);
+    apiObjectForSource.pushAll({{2, {{0, 60}}}, {1, {}}}, true);
+    assert(apiObjectForSource.size() == 6);
 
-    assert(apiObjectForSink.size() == 5);
+    assert(apiObjectForSink.size() == 6);
+    assert(apiObjectForSink.pop() == 60);
     assert(apiObjectForSink.pop() == 50);
     assert(apiObjectForSink.pop() == 40);
     assert(apiObjectForSink.pop() == 30);